@@ -168,9 +168,8 @@ EdgeDriver<D2_t>  d2(d2Start, d2Process, nullptr);
 EdgeDriver<D3_t>  d3(d3Start, d3Process, nullptr);
 
 void driversStart(void);
-void driversProcess(void);
 
-EdgeDriver<Drivers_t>  drivers(driversStart, driversProcess, nullptr);
+EdgeDriver<Drivers_t>  drivers(driversStart, nullptr, nullptr);
 
 String aux_d1stats(AutoConnectAux& aux, PageArgument& args) {
   aux["d1stats"].value = String(d1.data.stats);
@@ -183,7 +182,7 @@ String aux_d2stats(AutoConnectAux& aux, PageArgument& args) {
 }
 
 String aux_d3stats(AutoConnectAux& aux, PageArgument& args) {
-  aux["d3tats"].value = String(d3.data.stats);
+  aux["d3stats"].value = String(d3.data.stats);
   return String();
 }
 
@@ -211,10 +210,16 @@ void d3Process(void) {
   d3.data.stats++;
 }
 
+// Each driver owns its stats page. EdgeUnified joins the page while the
+// driver is enabled and releases it when the driver is disabled, so the
+// sketch no longer needs to check the page existence with AutoConnect::aux.
 void driversStart(void) {
-  Edge.attach(d1, 1000);
-  Edge.attach(d2, 1000);
-  Edge.attach(d3, 1000);
+  Edge.attach(d1, { {STATS_D1, aux_d1stats} }, 1000);
+  Edge.attach(d2, { {STATS_D2, aux_d2stats} }, 1000);
+  Edge.attach(d3, { {STATS_D3, aux_d3stats} }, 1000);
+  d1.enable(drivers.data.d1);
+  d2.enable(drivers.data.d2);
+  d3.enable(drivers.data.d3);
 }
 
 AutoConnect portal;
@@ -235,45 +240,14 @@ String aux_drivers(AutoConnectAux& aux, PageArgument& args) {
   drivers.data.d3 = request["d3"].as<AutoConnectCheckbox>().checked;
   request["d3stats"].as<AutoConnectSubmit>().enable = drivers.data.d3;
 
-  return String();
-}
-
-void driversProcess(void) {
+  // Changing the enable state of the drivers joins or releases their stats
+  // pages at the same time.
   d1.enable(drivers.data.d1);
-  if (drivers.data.d1) {
-    if (!portal.aux("/d1-stats")) {
-      Edge.join(STATS_D1, aux_d1stats);
-      Serial.printf("Free heap: %" PRIu32 "\n", ESP.getFreeHeap());
-    }
-  }
-  else if (portal.aux("/d1-stats")) {
-    Edge.release("/d1-stats");
-    Serial.printf("Free heap: %" PRIu32 "\n", ESP.getFreeHeap());
-  }
-
   d2.enable(drivers.data.d2);
-  if (drivers.data.d2) {
-    if (!portal.aux("/d2-stats")) {
-      Edge.join(STATS_D2, aux_d2stats);
-      Serial.printf("Free heap: %" PRIu32 "\n", ESP.getFreeHeap());
-    }
-  }
-  else if (portal.aux("/d2-stats")) {
-    Edge.release("/d2-stats");
-    Serial.printf("Free heap: %" PRIu32 "\n", ESP.getFreeHeap());
-  }
-
   d3.enable(drivers.data.d3);
-  if (drivers.data.d3) {
-    if (!portal.aux("/d3-stats")) {
-      Edge.join(STATS_D3, aux_d1stats);
-      Serial.printf("Free heap: %" PRIu32 "\n", ESP.getFreeHeap());
-    }
-  }
-  else if (portal.aux("/d3-stats")) {
-    Edge.release("/d3-stats");
-    Serial.printf("Free heap: %" PRIu32 "\n", ESP.getFreeHeap());
-  }
+  Serial.printf("Free heap: %" PRIu32 "\n", ESP.getFreeHeap());
+
+  return String();
 }
 
 void setup() {
@@ -402,6 +402,10 @@ void startMQTT() {
   mqtt.data.inPublish = false;
   mqtt.data.retryInterval = 5000;
   mqttClient.setServer(mqtt.data.server.c_str(), 1883);
+  // The publishing period is the interval of the EdgeDriver process, and the
+  // error retry is scheduled by EdgeDriver with the backoff up to 3 times.
+  mqtt.setEdgeInterval(mqtt.data.publishInterval);
+  mqtt.retryPolicy(mqtt.data.retryInterval, mqtt.data.retryInterval * 4, 3);
   if (mqtt.data.hostname.length()) {
     if (!mqtt.data.hostname.equalsIgnoreCase(String(WiFi.getHostname()))) {
       WiFi.setHostname(mqtt.data.hostname.c_str());
@@ -430,45 +434,37 @@ void startMQTT() {
  */
 void processMQTT() {
   if (mqtt.data.server.length()) {
-    if (millis() > mqtt.data.nextPeriod) {
-      // Attempts to connect to the MQTT broker based on a valid server name.
-      // mqttClient.setServer(mqtt.data.server.c_str(), 1883);
-      if (!mqttClient.connected()) {
-        Serial.println(String("Attempting MQTT broker:") + mqtt.data.server);
-        if ((mqtt.data.inPublish = mqttClient.connect(mqtt.data.clientid.c_str(), mqtt.data.username.c_str(), mqtt.data.password.c_str())))
-          Serial.println("Established:" + mqtt.data.clientid);
-        else
-          Serial.print("Connection failed:" + String(mqttClient.state()));
-      }
+    // Attempts to connect to the MQTT broker based on a valid server name.
+    // mqttClient.setServer(mqtt.data.server.c_str(), 1883);
+    if (!mqttClient.connected()) {
+      Serial.println(String("Attempting MQTT broker:") + mqtt.data.server);
+      if ((mqtt.data.inPublish = mqttClient.connect(mqtt.data.clientid.c_str(), mqtt.data.username.c_str(), mqtt.data.password.c_str())))
+        Serial.println("Established:" + mqtt.data.clientid);
+      else
+        Serial.print("Connection failed:" + String(mqttClient.state()));
+    }
 
-      if (mqtt.data.inPublish) {
-        String  topic = String("channels/") + mqtt.data.channelid + String("/publish");
-        String  message = String("field1=") + String(getStrength(7));
-        mqttClient.publish(topic.c_str(), message.c_str());
-        mqtt.data.inPublish = mqttClient.loop();
-        if (!mqtt.data.inPublish)
-          Serial.print("MQTT publishing failed");
-      }
+    if (mqtt.data.inPublish) {
+      String  topic = String("channels/") + mqtt.data.channelid + String("/publish");
+      String  message = String("field1=") + String(getStrength(7));
+      mqttClient.publish(topic.c_str(), message.c_str());
+      mqtt.data.inPublish = mqttClient.loop();
+      if (!mqtt.data.inPublish)
+        Serial.print("MQTT publishing failed");
+    }
 
-      if (mqtt.data.inPublish) {
-        mqttClient.disconnect();
-        mqtt.data.nextPeriod = millis() + mqtt.data.publishInterval;
-        mqtt.data.retry = 0;
-      }
-      else {
-        // Error retry. By varying the interval until the next turn of the
-        // process called, the processMQTT performs an error retry without an
-        // internal loop.
-        if (mqtt.data.retry++ < 3) {
-          mqtt.data.nextPeriod = millis() + mqtt.data.retryInterval;
-          Serial.printf("...retrying %d\n", mqtt.data.retry);
-        }
-        else {
-          mqtt.data.nextPeriod = millis() + mqtt.data.publishInterval;
-          mqtt.data.retry = 0;
-          Serial.println(", retries exceeded, abandoned.");
-        }
-      }
+    if (mqtt.data.inPublish) {
+      mqttClient.disconnect();
+      mqtt.succeeded();
+    }
+    else {
+      // Error retry. EdgeDriver defers the next turn of the process with the
+      // backoff delay, so the processMQTT performs an error retry without an
+      // internal loop.
+      if (mqtt.retryLater())
+        Serial.printf("...retrying %d\n", mqtt.getRetries());
+      else
+        Serial.println(", retries exceeded, abandoned.");
     }
   }
 }
@@ -30,8 +30,6 @@ typedef struct {
   String  hostname;
   unsigned long publishInterval;
   unsigned long retryInterval;
-  unsigned long nextPeriod;
-  int   retry;
   bool  inPublish;
 } MQTT_t;
 
@@ -142,6 +142,8 @@ String auxGPIOApply(AutoConnectAux& aux, PageArgument& args) {
   gpio.data.pin = aux["pin"].as<AutoConnectText>().value.toInt();
   gpio.data.cycle = aux["cycle"].as<AutoConnectText>().value.toInt();
   gpio.setEdgeInterval(gpio.data.cycle);
+  pinMode(gpio.data.pin, OUTPUT);
+  gpio.offloadPWM(gpio.data.pin, gpio.data.cycle * 2000UL);
   gpio.save();
   return String();
 }
@@ -154,10 +156,15 @@ void startGPIO() {
   pinMode(gpio.data.pin, OUTPUT);
   digitalWrite(gpio.data.pin, !LED_ACTIVE);
   gpio.setEdgeInterval(gpio.data.cycle);
+  // Blinking is a pure waveform that the hardware can generate by itself.
+  // The offloaded gpio leaves the loop, and processGPIO toggling the LED
+  // remains as the fallback when no hardware can take over the blinking.
+  gpio.offloadPWM(gpio.data.pin, gpio.data.cycle * 2000UL);
 }
 
 /**
  * GPIO process callback
+ * It is the software fallback of the blinking offloaded to the hardware.
  */
 void processGPIO() {
   digitalWrite(gpio.data.pin, !digitalRead(gpio.data.pin));
@@ -7,19 +7,25 @@
   3. AutoConnectAux custom web page request handlers.
   4. On-demand callback functions.
   5. EdgeData serializer and deserializer in optionally.
+  This module builds the MQTT EdgeDriver on EdgeMQTTDriver provided by the
+  EdgeUnified library. EdgeMQTTDriver keeps the session with the broker and
+  also provides the serializer and deserializer of its EdgeData, so the
+  module only implements the publishing payload and the custom web pages.
   Copyright (c) 2022 Hieromon Ikasamo.
   This software is released under the MIT License.
   https://opensource.org/licenses/MIT
 */
 
 #include "EdgeUnified.h"
+#include "EdgeMQTT.h"
+#include "EdgeSampler.h"
 
 #if defined(ARDUINO_ARCH_ESP8266)
 #include <ESP8266HTTPClient.h>
 #elif defined(ARDUINO_ARCH_ESP32)
 #include <HTTPClient.h>
+#include <lwip/sockets.h>
 #endif
-#include <PubSubClient.h>
 
 /*
   The mqtt.hpp source code file is not a compilation unit. It suggests a way
@@ -50,29 +56,16 @@
 /**
  * Instance responsible for implementation of various IOs dependent on EdgeDriver.
  */
-WiFiClient    wifiClient;
-PubSubClient  mqttClient(wifiClient);
+// The MQTT session is kept open, so the HTTP request for clearing the
+// channel uses another WiFiClient in its job.
+WiFiClient    mqttWiFiClient;
 void startMDNS(void);
 
 namespace EdgeMQTT {
 
-// Define EdgeData structure for MQTT.
+// EdgeData structure for MQTT is EdgeMQTT_t declared by EdgeMQTT.h.
 // This is the data structure handled by MQTT EdgeDriver.
-typedef struct {
-  String  server;
-  String  apikey;
-  String  channelid;
-  String  writekey;
-  String  clientid;
-  String  username;
-  String  password;
-  String  hostname;
-  unsigned long publishInterval;
-  unsigned long retryInterval;
-  unsigned long nextPeriod;
-  int   retry;
-  bool  inPublish;
-} MQTT_t;
+typedef EdgeMQTT_t  MQTT_t;
 
 /**
  * MQTT custom Web page descriptions.
@@ -318,13 +311,17 @@ static const char STOP_MQTT[] PROGMEM = R"*(
 // Declares that main.ino can refer to EdgeDriver's on-demand functions. It is
 // referenced by the EdgeUnified::attach function.
 void startMQTT(void);
-void processMQTT(void);
-void endMQTT(void);
+void publishMQTT(EdgeMQTTDriver& driver);
 
 /**
  * Edge entities
  */
-EdgeDriver<MQTT_t>  mqtt(startMQTT, processMQTT, endMQTT);
+EdgeMQTTDriver  mqtt(mqttWiFiClient);
+
+// The WiFi signal strength is sampled by EdgeSampler one at a time every
+// 20 ms instead of a blocking loop with the delay. The publish callback
+// takes the mean of the latest 7 samples instantly.
+EdgeSampler<7>  rssi("rssi", []() { return static_cast<float>(WiFi.RSSI()); });
 
 /**
  * AutoConnectAux custom web page request handlers.
@@ -408,48 +405,164 @@ String auxMQTTStop(AutoConnectAux& aux, PageArgument& args) {
   return String();
 }
 
-// AutoConnectAux handler. Obtain AutoConnectElement values, copy to EdgeData
-String auxMQTTClear(AutoConnectAux& aux, PageArgument& args) {
-  HTTPClient  httpClient;
-
-  String  endpoint = mqtt.data.server;
-  endpoint.replace("mqtt3", "api");
-  String  delUrl = "http://" + endpoint + "/channels/" + mqtt.data.channelid + "/feeds.json?api_key=" + mqtt.data.apikey;
-
-  Serial.print("DELETE " + delUrl);
-  if (httpClient.begin(wifiClient, delUrl)) {
-    Serial.print(":");
-    int resCode = httpClient.sendRequest("DELETE");
-    const String& res = httpClient.getString();
-    Serial.println(String(resCode) + String(",") + res);
-    httpClient.end();
+/**
+ * Job that clears the channel feed with the DELETE request of the ThingSpeak
+ * REST API. EdgeUnified calls the job every turn of the process, and each
+ * call advances only one step of connecting, sending the request and
+ * reading the response, returning ED_JOB_CONTINUE in between. So the other
+ * EdgeDrivers and the web server keep running during the round trip.
+ * ESP32 connects with a non-blocking socket. The WiFiClient of ESP8266 has
+ * no non-blocking connect, so the connection step there waits up to
+ * CLEAR_CONNECT_TIMEOUT. The name resolution of the host blocks on both.
+ */
+const unsigned long CLEAR_CONNECT_TIMEOUT = 3000;
+const unsigned long CLEAR_RESPONSE_TIMEOUT = 10000;
+
+class ClearChannel {
+ public:
+  ClearChannel(const String& host, const String& path) : _host(host), _path(path) {}
+  ~ClearChannel() {
+#if defined(ARDUINO_ARCH_ESP32)
+    if (_fd >= 0)
+      lwip_close(_fd);
+#endif
+    _client.stop();
   }
-  else
-    Serial.println(" failed");
 
-  aux.redirect("/");
-  return String();
-}
+  int step(void) {
+    switch (_state) {
+    case BEGIN:
+      _tm = millis();
+      if (!_connect())
+        return _finish(HTTPC_ERROR_CONNECTION_FAILED);
+      _state = CONNECTING;
+      break;
+
+    case CONNECTING: {
+      int rc = _connected();
+      if (rc < 0 || (!rc && millis() - _tm > CLEAR_CONNECT_TIMEOUT))
+        return _finish(HTTPC_ERROR_CONNECTION_FAILED);
+      if (rc) {
+        _client.print(String("DELETE ") + _path + " HTTP/1.1\r\nHost: " + _host + "\r\nConnection: close\r\n\r\n");
+        _tm = millis();
+        _state = RESPONDING;
+      }
+      break;
+    }
 
-int getStrength(uint8_t points) {
-  uint8_t sc = points;
-  long    rssi = 0;
+    case RESPONDING:
+      // Only the status line such as "HTTP/1.1 200 OK" is needed.
+      while (_client.available()) {
+        char  c = _client.read();
+        if (c == '\n') {
+          int sp = _line.indexOf(' ');
+          return _finish(sp > 0 ? _line.substring(sp + 1).toInt() : HTTPC_ERROR_NO_HTTP_SERVER);
+        }
+        if (c != '\r' && _line.length() < 64)
+          _line += c;
+      }
+      if (!_client.connected())
+        return _finish(HTTPC_ERROR_CONNECTION_LOST);
+      if (millis() - _tm > CLEAR_RESPONSE_TIMEOUT)
+        return _finish(HTTPC_ERROR_READ_TIMEOUT);
+      break;
+    }
+    return ED_JOB_CONTINUE;
+  }
 
-  while (sc--) {
-    rssi += WiFi.RSSI();
-    delay(20);
+ private:
+  bool  _connect(void) {
+#if defined(ARDUINO_ARCH_ESP8266)
+    _client.setTimeout(CLEAR_CONNECT_TIMEOUT);
+    return _client.connect(_host.c_str(), 80);
+#elif defined(ARDUINO_ARCH_ESP32)
+    IPAddress ip;
+    if (!WiFi.hostByName(_host.c_str(), ip))
+      return false;
+    _fd = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (_fd < 0)
+      return false;
+    lwip_fcntl(_fd, F_SETFL, lwip_fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+    struct sockaddr_in  addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = static_cast<uint32_t>(ip);
+    addr.sin_port = htons(80);
+    return lwip_connect(_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0 || errno == EINPROGRESS;
+#endif
   }
-  return points ? static_cast<int>(rssi / points) : 0;
+
+  // Returns 1 when connected, 0 while connecting and -1 if failed.
+  int _connected(void) {
+#if defined(ARDUINO_ARCH_ESP8266)
+    return _client.connected() ? 1 : -1;
+#elif defined(ARDUINO_ARCH_ESP32)
+    fd_set  fdset;
+    struct timeval  tv = { 0, 0 };
+    FD_ZERO(&fdset);
+    FD_SET(_fd, &fdset);
+    int rc = lwip_select(_fd + 1, nullptr, &fdset, nullptr, &tv);
+    if (rc <= 0)
+      return rc;
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (lwip_getsockopt(_fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err)
+      return -1;
+    // WiFiClient takes over the socket in the blocking mode.
+    lwip_fcntl(_fd, F_SETFL, lwip_fcntl(_fd, F_GETFL, 0) & ~O_NONBLOCK);
+    _client = WiFiClient(_fd);
+    _fd = -1;
+    return 1;
+#endif
+  }
+
+  int _finish(const int resCode) {
+    Serial.println("DELETE http://" + _host + _path + ":" + String(resCode));
+    _client.stop();
+    return resCode;
+  }
+
+  enum { BEGIN, CONNECTING, RESPONDING } _state = BEGIN;
+  String  _host;
+  String  _path;
+  String  _line;
+  WiFiClient  _client;
+  unsigned long _tm = 0;
+#if defined(ARDUINO_ARCH_ESP32)
+  int _fd = -1;
+#endif
+};
+
+// AutoConnectAux handler. Obtain AutoConnectElement values, copy to EdgeData
+String auxMQTTClear(AutoConnectAux& aux, PageArgument& args) {
+  String  host = mqtt.data.server;
+  host.replace("mqtt3", "api");
+  String  path = "/channels/" + mqtt.data.channelid + "/feeds.json?api_key=" + mqtt.data.apikey;
+
+  // The DELETE request waits for the remote response, so it is submitted as
+  // a job to EdgeUnified and the handler responds immediately. The result
+  // is reported by the completion callback and ED_JOBS_PATH.
+  std::shared_ptr<ClearChannel> clear = std::make_shared<ClearChannel>(host, path);
+  uint16_t  id = Edge.submit([clear]() {
+    return clear->step();
+  }, [](const uint16_t id, const int result) {
+    Serial.printf("Clear channel job %u done:%d\n", id, result);
+  });
+
+  if (!id)
+    Serial.println("DELETE http://" + host + path + " failed, job queue full");
+
+  aux.redirect("/");
+  return String();
 }
 
 /**
  * MQTT start callback
+ * EdgeMQTTDriver sets up the broker by itself. The callback applies the
+ * host name of ESP module.
  */
 void startMQTT() {
   Serial.println("Starting MQTT");
-  mqtt.data.inPublish = false;
-  mqtt.data.retryInterval = 5000;
-  mqttClient.setServer(mqtt.data.server.c_str(), 1883);
   if (mqtt.data.hostname.length()) {
     if (!mqtt.data.hostname.equalsIgnoreCase(String(WiFi.getHostname()))) {
       WiFi.setHostname(mqtt.data.hostname.c_str());
@@ -459,108 +572,18 @@ void startMQTT() {
 }
 
 /**
- * MQTT process callback
- * By checking the connection with the broker at the time of the publish
- * request, it can delegate the reconnection attempt to the loop function.
- * This strategy eliminates handling the delay that occurs during the
- * broker reconnection attempt loop and smooth AutoConnect communication
- * with the client.
- * 
- * Note that the following the processMQTT callback function do not have their
- * own loop logic. It has an error retry structure when MQTT issuance fails,
- * and even the retry processing does not form a loop within the processMQTT.
- * 
- * In the Arduino framework, the loop() function itself is the actual event
- * loop. Forming a small independent loop inside the loop function is not
- * appropriate as a programming structure because it interferes with other
- * processing.
- * 
- */
-void processMQTT() {
-  if (mqtt.data.server.length()) {
-    if (millis() > mqtt.data.nextPeriod) {
-      // Attempts to connect to the MQTT broker based on a valid server name.
-      // mqttClient.setServer(mqtt.data.server.c_str(), 1883);
-      if (!mqttClient.connected()) {
-        Serial.println(String("Attempting MQTT broker:") + mqtt.data.server);
-        if ((mqtt.data.inPublish = mqttClient.connect(mqtt.data.clientid.c_str(), mqtt.data.username.c_str(), mqtt.data.password.c_str())))
-          Serial.println("Established:" + mqtt.data.clientid);
-        else
-          Serial.print("Connection failed:" + String(mqttClient.state()));
-      }
-
-      if (mqtt.data.inPublish) {
-        String  topic = String("channels/") + mqtt.data.channelid + String("/publish");
-        String  message = String("field1=") + String(getStrength(7));
-        mqttClient.publish(topic.c_str(), message.c_str());
-        mqtt.data.inPublish = mqttClient.loop();
-        if (!mqtt.data.inPublish)
-          Serial.print("MQTT publishing failed");
-      }
-
-      if (mqtt.data.inPublish) {
-        mqttClient.disconnect();
-        mqtt.data.nextPeriod = millis() + mqtt.data.publishInterval;
-        mqtt.data.retry = 0;
-      }
-      else {
-        // Error retry. By varying the interval until the next turn of the
-        // process called, the processMQTT performs an error retry without an
-        // internal loop.
-        if (mqtt.data.retry++ < 3) {
-          mqtt.data.nextPeriod = millis() + mqtt.data.retryInterval;
-          Serial.printf("...retrying %d\n", mqtt.data.retry);
-        }
-        else {
-          mqtt.data.nextPeriod = millis() + mqtt.data.publishInterval;
-          mqtt.data.retry = 0;
-          Serial.println(", retries exceeded, abandoned.");
-        }
-      }
-    }
-  }
-}
-
-/**
- * MQTT end callback
+ * MQTT publish callback
+ * EdgeMQTTDriver calls the publish callback every publishInterval. The
+ * session is kept open and the reconnection with the backoff is done by
+ * EdgeMQTTDriver, so the callback only has to queue the message. The topic
+ * is built by EdgeMQTTDriver from the channel ID, and the payload is formatted
+ * into the buffer of the driver without the String concatenation. The queued
+ * messages are kept while the broker is unreachable and are published in
+ * order when the session is re-established.
  */
-void endMQTT() {
-  mqttClient.disconnect();
-  mqtt.data.inPublish = false;
-  Serial.println("MQTT publishing stopped\n");
-}
-
-/**
- * EdgeData serializer
- * If EdgeData contains class objects, EdgeUnified converts to JSON and
- * exports it to the file system. Import from the file system also assumes
- * that EdgeData is in JSON format. The serializer and deserializer support
- * inter-conversion between JSON objects and EdgeData instances.
- */
-// Serializer: MQTT_t EdgeData. to MQTT EdgeData JSON object. 
-void mqttSerialize(JsonObject& edgeData) {
-  edgeData[F("server")] = mqtt.data.server;
-  edgeData[F("apikey")] = mqtt.data.apikey;
-  edgeData[F("channelid")] = mqtt.data.channelid;
-  edgeData[F("writekey")] = mqtt.data.writekey;
-  edgeData[F("clientid")] = mqtt.data.clientid;
-  edgeData[F("username")] = mqtt.data.username;
-  edgeData[F("password")] = mqtt.data.password;
-  edgeData[F("hostname")] = mqtt.data.hostname;
-  edgeData[F("publishInterval")] = mqtt.data.publishInterval;
-}
-
-// Deserializer: MQTT EdgeData JSON object to MQTT_t EdgeData.
-void mqttDeserialize(JsonObject& edgeData) {
-  mqtt.data.server = edgeData[F("server")].as<String>();
-  mqtt.data.apikey = edgeData[F("apikey")].as<String>();
-  mqtt.data.channelid = edgeData[F("channelid")].as<String>();
-  mqtt.data.writekey = edgeData[F("writekey")].as<String>();
-  mqtt.data.clientid = edgeData[F("clientid")].as<String>();
-  mqtt.data.username = edgeData[F("username")].as<String>();
-  mqtt.data.password = edgeData[F("password")].as<String>();
-  mqtt.data.hostname = edgeData[F("hostname")].as<String>();
-  mqtt.data.publishInterval = edgeData[F("publishInterval")].as<unsigned long>();
+void publishMQTT(EdgeMQTTDriver& driver) {
+  driver.field(1, static_cast<long>(rssi.mean()));
+  driver.enqueue();
 }
 
 }
@@ -12,16 +12,17 @@
 #if defined(ARDUINO_ARCH_ESP8266)
 #include <ESP8266WiFi.h>
 #include <ESP8266mDNS.h>
-#define mDNSUpdate()  do {MDNS.update();} while (0)
 #elif defined(ARDUINO_ARCH_ESP32)
 #include <WiFi.h>
 #include <ESPmDNS.h>
-#define mDNSUpdate() do {(void)0;} while(0)
 #endif
 #include <AutoConnect.h>
 
 // Include the EdgeUnified header.
 #include "EdgeUnified.h"
+// The service drivers run AutoConnect::handleClient and MDNS.update as
+// EdgeDrivers.
+#include "EdgeServices.h"
 
 /**
  * Declare required instances.
@@ -29,6 +30,8 @@
 WebServer   server;
 AutoConnect portal(server);
 AutoConnectConfig config;
+EdgePortalService portalService(portal);
+EdgeMDNSService   mdnsService;
 
 // Include the module header for the EdgeDriver to be used.
 // Note that all included source code files are treated by the compiler as a
@@ -141,7 +144,13 @@ void setup() {
 
   gpio.autoRestore(true);
   mqtt.autoRestore(true);
-  mqtt.serializer(mqttSerialize, mqttDeserialize, 512);
+  // EdgeMQTTDriver has its own serializer and deserializer, and calls the
+  // sketch back on the start and every publishing period.
+  mqtt.onStart(startMQTT);
+  mqtt.onPublish(publishMQTT);
+  // The small publishes over the kept session would wait for the delayed
+  // ACK of the broker behind the Nagle algorithm.
+  mqtt.onConnect([](EdgeMQTTDriver&) { mqttWiFiClient.setNoDelay(true); });
 
   /*
     To make the EdgeDriver a member of the event loop by EdgeUnified, register
@@ -150,11 +159,21 @@ void setup() {
     two examples register gpio and mqtt EdgeDriver separately.
    */
   Edge.attach(gpio);
-  Edge.attach(mqtt);
+  // The mqtt EdgeDriver requires the WiFi connection, EdgeUnified starts it
+  // once WiFi has connected and ends it while WiFi is disconnected. The
+  // rssi sampler feeds the mqtt publishing, it follows the mqtt EdgeDriver.
+  Edge.attach(mqtt, { EdgeRequire::WiFiConnected() });
+  Edge.attach(rssi, { mqtt });
   // Multiple EdgeDrivers can be registered at one time. In this case, multiple
   // EdgeDrivers are specified by enclosing them with '{' and '}'.
   // Edge.attach({ gpio, mqtt });
 
+  // The service drivers are attached in the same way. The portal service
+  // has a higher priority than the other EdgeDrivers so that EdgeUnified
+  // serves the HTTP requests first, and it calls handleClient every loop
+  // only while the requests are arriving.
+  Edge.attach({ portalService, mdnsService });
+
   /*
     To make the EdgeDriver a member of the event loop by EdgeUnified, register
     the EdgeDriver using the EdgeUnified::attach function.
@@ -221,14 +240,9 @@ void loop() {
 
   // Consecutively calls the process function of the EdgeDrivers bound to the
   // EdgeUnifined to execute an event loop.
-  // EdgeUnified::process function with the portal argument allows EdgeUnified
-  // to dynamically load and bind AutoConnectAux. Sketches can release and join
-  // AutoConnectAuxes during EdgeUnified's event loop using the process function
-  // with a portal argument.
-  Edge.process(portal);
-
-  // The post process of the loop function calls other service instances that
-  // need to be invoked as event loops.
-  mDNSUpdate();
-  portal.handleClient();
+  // The portal service has bound AutoConnect to EdgeUnified, so the process
+  // function without the portal argument can dynamically load and bind
+  // AutoConnectAux. AutoConnect::handleClient and MDNS.update are also called
+  // from the process function by the service drivers.
+  Edge.process();
 }
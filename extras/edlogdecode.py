@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""Decoder of the deferred debug output of EdgeUnified.
+
+EdgeUnified built with ED_DEBUG and ED_DEBUG_DEFERRED=2 writes each ED_DBG
+call as a binary frame that carries the address of the format string and the
+raw arguments. This script looks up the format strings in the ELF file of
+the sketch and expands the frames to the text. The bytes outside the frames,
+such as the boot messages of the ROM, pass through as they are.
+
+Frame layout (little-endian):
+  0xED, flags (bit 0: truncated), length of the arguments,
+  time [us] (4 bytes), address of the format string (4 bytes), arguments
+
+usage: edlogdecode.py [-t] sketch.elf [capture]
+  The capture is a file or a serial port such as /dev/ttyUSB0. It reads
+  the standard input if omitted. Reading the serial port requires pyserial.
+  -t prefixes each line with the time of the ED_DBG call.
+
+Requires pyelftools (pip install pyelftools).
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+from elftools.elf.constants import SH_FLAGS
+from elftools.elf.elffile import ELFFile
+
+SYNC = 0xED
+HEADER = 11
+
+SPEC = re.compile(rb'%([-+ #0]*(?:\d+|\*)?(?:\.(?:\d+|\*))?)(hh|h|ll|l|j|z|t)?([diouxXcfeEgGps%])')
+
+
+class FormatTable:
+    """Format strings of the sketch looked up by the address."""
+
+    def __init__(self, path):
+        self._sections = []
+        self._cache = {}
+        with open(path, 'rb') as f:
+            elf = ELFFile(f)
+            for section in elf.iter_sections():
+                if (section['sh_flags'] & SH_FLAGS.SHF_ALLOC and
+                        section['sh_type'] == 'SHT_PROGBITS'):
+                    self._sections.append((section['sh_addr'], section.data()))
+
+    def lookup(self, addr):
+        if addr not in self._cache:
+            self._cache[addr] = None
+            for base, data in self._sections:
+                if base <= addr < base + len(data):
+                    end = data.find(b'\0', addr - base)
+                    if end >= 0:
+                        self._cache[addr] = data[addr - base:end]
+                    break
+        return self._cache[addr]
+
+
+def expand(fmt, args, truncated):
+    """Formats the arguments as the device formats them with ED_DEBUG_DEFERRED=1."""
+    out = bytearray()
+    pos = 0
+    last = 0
+    for m in SPEC.finditer(fmt):
+        out += fmt[last:m.start()]
+        last = m.end()
+        flags, length, conv = m.group(1), m.group(2), m.group(3)
+        if conv == b'%':
+            out += b'%'
+            continue
+        wide = length == b'll'
+        try:
+            # The width and the precision given by `*` precede the argument
+            while b'*' in flags:
+                if pos + 4 > len(args):
+                    raise ValueError
+                star = struct.unpack_from('<i', args, pos)[0]
+                pos += 4
+                flags = flags.replace(b'*', b'%d' % star, 1)
+            if conv in b'dic':
+                size, code = (8, '<q') if wide else (4, '<i')
+            elif conv in b'ouxX':
+                size, code = (8, '<Q') if wide else (4, '<I')
+            elif conv in b'eEfgG':
+                size, code = 8, '<d'
+            elif conv == b'p':
+                size, code = 4, '<I'
+            else:
+                end = args.index(b'\0', pos)
+                value = args[pos:end]
+                pos = end + 1
+                out += (b'%' + flags + b's') % value
+                continue
+            if pos + size > len(args):
+                raise ValueError
+            value = struct.unpack_from(code, args, pos)[0]
+            pos += size
+            if conv == b'p':
+                out += b'0x%08x' % value
+            else:
+                pyconv = b'd' if conv in b'iu' else conv
+                out += (b'%' + flags + pyconv) % value
+        except ValueError:
+            # The argument was truncated on the device
+            out += m.group(0)
+    out += fmt[last:]
+    if truncated:
+        eol = len(out) - len(out.rstrip(b'\r\n'))
+        out[len(out) - eol:len(out) - eol] = b' (truncated)'
+    return bytes(out)
+
+
+def decode(stream, table, timestamp, write):
+    buf = bytearray()
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            break
+        buf += chunk
+        while buf:
+            if buf[0] != SYNC:
+                write(bytes(buf[:1]))
+                del buf[:1]
+                continue
+            if len(buf) < HEADER or len(buf) < HEADER + buf[2]:
+                break
+            flags, length = buf[1], buf[2]
+            tm, addr = struct.unpack_from('<II', buf, 3)
+            fmt = table.lookup(addr) if flags <= 1 else None
+            if fmt is None:
+                # Not a frame
+                write(bytes(buf[:1]))
+                del buf[:1]
+                continue
+            text = expand(fmt, bytes(buf[HEADER:HEADER + length]), flags & 1)
+            if timestamp:
+                text = b'%10.6f ' % (tm / 1e6) + text
+            write(text)
+            del buf[:HEADER + length]
+    write(bytes(buf))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode the deferred debug output of EdgeUnified.')
+    parser.add_argument('-t', '--timestamp', action='store_true', help='prefix the time of the call')
+    parser.add_argument('-b', '--baud', type=int, default=115200, help='baud rate of the serial port')
+    parser.add_argument('elf', help='ELF file of the sketch')
+    parser.add_argument('capture', nargs='?', help='captured output or serial port')
+    args = parser.parse_args()
+
+    table = FormatTable(args.elf)
+    if not args.capture:
+        stream = sys.stdin.buffer
+    elif args.capture.startswith('/dev/') or args.capture.upper().startswith('COM'):
+        import serial
+        stream = serial.Serial(args.capture, args.baud)
+    else:
+        stream = open(args.capture, 'rb')
+
+    def write(data):
+        sys.stdout.buffer.write(data)
+        sys.stdout.buffer.flush()
+
+    try:
+        decode(stream, table, args.timestamp, write)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""Test client of the Server-Sent Events telemetry of EdgeUnified.
+
+It subscribes to ED_EVENTS_PATH of the device and checks each event against
+the rules of EdgeUnified::events:
+  - The events come at most once per interval. The keep-alive comments are
+    not counted.
+  - Each event is one JSON object that batches the changed fields of all
+    EdgeDrivers keyed by the type name of EdgeData.
+  - The first event carries all fields, and the following events carry
+    only the fields whose values have changed since they were pushed last.
+It prints each event with the time since the previous one, and exits with
+status 1 if some event has broken the rules. Another subscriber joining
+makes the device send all fields to every connection, so the client should
+be the only subscriber during the check.
+
+usage: edsseclient.py [-i interval] [-t tolerance] [-n events] [-d seconds] url
+  The url is such as http://esp32.local/edge/events. The interval is the
+  one given to EdgeUnified::events [ms], 1000 by default.
+"""
+
+import argparse
+import json
+import sys
+import time
+import urllib.request
+
+
+def events(stream):
+    """Yields the data of each event, and None for each comment."""
+    data = []
+    for raw in stream:
+        line = raw.decode('utf-8').rstrip('\r\n')
+        if not line:
+            if data:
+                yield '\n'.join(data)
+                data = []
+        elif line.startswith(':'):
+            yield None
+        elif line.startswith('data:'):
+            data.append(line[5:].lstrip(' '))
+
+
+def check(stream, interval, tolerance, limit, duration, out):
+    last = {}
+    prev = None
+    count = 0
+    errors = 0
+    start = time.monotonic()
+
+    for data in events(stream):
+        now = time.monotonic()
+        if data is None:
+            out('%10.3f keep-alive' % (now - start))
+        else:
+            problems = []
+            gap = (now - prev) * 1000 if prev is not None else None
+            if gap is not None and gap + tolerance < interval:
+                problems.append('%.0f ms after the previous event' % gap)
+            prev = now
+
+            try:
+                frame = json.loads(data)
+            except ValueError:
+                frame = None
+            if not isinstance(frame, dict) or not all(isinstance(v, dict) for v in frame.values()):
+                problems.append('not a batch of the EdgeDrivers')
+                frame = {}
+
+            for driver, fields in frame.items():
+                known = last.setdefault(driver, {})
+                for key, value in fields.items():
+                    if count and key in known and known[key] == value:
+                        problems.append('%s.%s unchanged' % (driver, key))
+                    known[key] = value
+
+            count += 1
+            out('%10.3f %s event %d, %s' % (now - start, 'full' if count == 1 else 'delta', count,
+                                            ', '.join('%s:%d' % (d, len(f)) for d, f in frame.items())))
+            for problem in problems:
+                out('           NG: ' + problem)
+            errors += bool(problems)
+            if limit and count >= limit:
+                break
+        if duration and now - start >= duration:
+            break
+
+    return count, errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Check the Server-Sent Events telemetry of EdgeUnified.')
+    parser.add_argument('-i', '--interval', type=float, default=1000, help='minimum interval of the events [ms]')
+    parser.add_argument('-t', '--tolerance', type=float, default=50, help='tolerance of the interval [ms]')
+    parser.add_argument('-n', '--events', type=int, default=0, help='stop after the number of the events')
+    parser.add_argument('-d', '--duration', type=float, default=0, help='stop after the seconds')
+    parser.add_argument('url', help='url of ED_EVENTS_PATH')
+    args = parser.parse_args()
+
+    request = urllib.request.Request(args.url, headers={'Accept': 'text/event-stream'})
+    try:
+        with urllib.request.urlopen(request) as stream:
+            count, errors = check(stream, args.interval, args.tolerance, args.events, args.duration, print)
+    except KeyboardInterrupt:
+        return 0
+    print('%d events, %d broke the rules' % (count, errors))
+    return 1 if errors or not count else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
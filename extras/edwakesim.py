@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Host simulation of the wakeup coalescing of EdgeUnified.
+
+It runs the EdgeDrivers with the given intervals and slacks through the
+same rules as EdgeDriverBase::_elapse and EdgeUnified::nextWake, assuming
+that the loop sleeps until the next wake slot between the turns and that the
+process calls take no time. It reports the number of the distinct wakeups
+per hour and the average idle gap between them, without the coalescing
+(all slacks are zero) and with the coalescing.
+
+usage: edwakesim.py [-d hours] interval[:slack] ...
+  Each driver is given by its interval [ms] and the slack [ms]. The default
+  is 500:100 (blink) 30000:5000 (publish) 1000:200 (stats).
+"""
+
+import argparse
+
+
+class Driver:
+    def __init__(self, interval, slack):
+        self.interval = interval
+        self.slack = slack
+        self.tm = 0
+        self.runs = 0
+
+    def remain(self, now):
+        # EdgeDriverBase::_remain, the process is due when elapsed > interval
+        return self.interval - (now - self.tm) + 1
+
+    def elapse(self, now, slot, coalesce):
+        elapsed = now - self.tm
+        due = elapsed > self.interval
+        if coalesce and self.slack:
+            due = elapsed + self.slack > self.interval if slot else elapsed > self.interval + self.slack
+        if due:
+            if coalesce and self.slack and elapsed <= self.interval + 1 + self.slack:
+                self.tm += self.interval + 1
+            else:
+                self.tm = now
+            self.runs += 1
+        return due
+
+
+def simulate(specs, duration, coalesce):
+    drivers = [Driver(interval, slack) for interval, slack in specs]
+    now = 0
+    wakes = []
+    while True:
+        # EdgeUnified::nextWake, the loop sleeps until the earliest end of the slack
+        now += max(0, min(d.remain(now) + (d.slack if coalesce else 0) for d in drivers))
+        if now > duration:
+            break
+        # The slot is open since the loop woke up at the end of the slack
+        ran = [d.elapse(now, True, coalesce) for d in drivers]
+        if any(ran):
+            wakes.append(now)
+    gaps = [b - a for a, b in zip(wakes, wakes[1:])]
+    return len(wakes), sum(gaps) / len(gaps) if gaps else float(duration), sum(d.runs for d in drivers)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Simulate the wakeup coalescing of EdgeUnified.')
+    parser.add_argument('-d', '--hours', type=float, default=1.0, help='simulated duration [h]')
+    parser.add_argument('drivers', nargs='*', default=['500:100', '30000:5000', '1000:200'],
+                        help='interval[:slack] of each EdgeDriver [ms]')
+    args = parser.parse_args()
+
+    specs = []
+    for spec in args.drivers:
+        interval, _, slack = spec.partition(':')
+        specs.append((int(interval), int(slack or 0)))
+    duration = int(args.hours * 3600000)
+
+    print('drivers: ' + ', '.join('%d ms +/-%d ms' % spec for spec in specs))
+    print('%-12s %14s %16s %12s' % ('coalescing', 'wakeups/hour', 'avg idle gap ms', 'runs/hour'))
+    for coalesce in (False, True):
+        wakes, gap, runs = simulate(specs, duration, coalesce)
+        print('%-12s %14.0f %16.1f %12.0f' % ('on' if coalesce else 'off', wakes / args.hours, gap, runs / args.hours))
+
+
+if __name__ == '__main__':
+    main()
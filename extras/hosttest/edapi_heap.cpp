@@ -0,0 +1,328 @@
+/**
+ *	Host benchmark of the heap for the REST endpoint against the page.
+ *	@file	edapi_heap.cpp
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ *
+ * It responds EdgeMQTT_t of EdgeMQTTDriver to the client in two ways, and
+ * reports the heap allocations, the peak of the heap in use and the writes
+ * to the client per response.
+ * - page: the round-trip of the mqtt_setting page of the yamqtt example.
+ *   The elements render their HTML into the String that makes up the page
+ *   and WebServer::send writes the page with its content length. The
+ *   String grows as the Arduino String does, reallocating to the exact
+ *   length on each concatenation. Only the ACInput elements are rendered,
+ *   without the style, the menu and the template of AutoConnect, so that
+ *   this is the lower bound of the page.
+ * - REST: EdgeUnified::_apiGet with the DynamicJsonDocument of
+ *   ED_MQTT_SERIALIZE_BUFFER_SIZE, the serializer output streamed through
+ *   the port of EdgeChunkedResponse, and the chunks sent as WebServer::
+ *   sendContent does.
+ * The response header is prepared into a String in both as WebServer does.
+ * The values are then made 4 times longer, and the test fails unless the
+ * peak of the REST response stays the same, since the body never enters
+ * the heap. The latency depends on the WiFi and is not measured here.
+ *
+ * usage: edapi_heap [responses]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace {
+
+// Same sizes as the default of EdgeUnified and EdgeMQTTDriver
+const size_t  CHUNK_BUFFER_SIZE = 128;                  // ED_CHUNK_BUFFER_SIZE
+const size_t  SERIALIZE_BUFFER_SIZE = 512;              // ED_MQTT_SERIALIZE_BUFFER_SIZE
+const size_t  TCP_MSS = 1460;
+
+bool  counting = false;
+size_t  allocations = 0;
+long  live = 0;
+long  peak = 0;
+
+// The heap with the size in the header of each block
+union Header {
+  size_t  size;
+  std::max_align_t  align;
+};
+
+void* edAlloc(const size_t size) {
+  Header* h = static_cast<Header*>(malloc(sizeof(Header) + size));
+  if (!h)
+    return nullptr;
+  h->size = size;
+  if (counting) {
+    allocations++;
+    live += size;
+    peak = std::max(peak, live);
+  }
+  return h + 1;
+}
+
+void  edFree(void* p) {
+  if (!p)
+    return;
+  Header* h = static_cast<Header*>(p) - 1;
+  if (counting)
+    live -= h->size;
+  free(h);
+}
+
+void* edRealloc(void* p, const size_t size) {
+  void* q = edAlloc(size);
+  if (q && p) {
+    memcpy(q, p, std::min(size, (static_cast<Header*>(p) - 1)->size));
+    edFree(p);
+  }
+  return q;
+}
+
+/**
+ * Stand-in of the Arduino String. The concatenation reallocates the buffer
+ * to the exact length as WString::changeBuffer does.
+ */
+class HostString {
+ public:
+  HostString() {}
+  ~HostString() { edFree(_buf); }
+
+  HostString& operator+=(const char* s) { return _concat(s, strlen(s)); }
+  HostString& operator+=(const HostString& s) { return _concat(s.c_str(), s.length()); }
+  HostString& operator+=(const unsigned long v) {
+    char  num[16];
+    return _concat(num, snprintf(num, sizeof(num), "%lu", v));
+  }
+
+  const char* c_str(void) const { return _buf ? _buf : ""; }
+  size_t  length(void) const { return _len; }
+
+ private:
+  HostString& _concat(const char* s, const size_t n) {
+    if (!n)
+      return *this;
+    if (_len + n > _cap) {
+      _buf = static_cast<char*>(edRealloc(_buf, _len + n + 1));
+      _cap = _len + n;
+    }
+    memcpy(_buf + _len, s, n);
+    _len += n;
+    _buf[_len] = '\0';
+    return *this;
+  }
+
+  char* _buf = nullptr;
+  size_t  _len = 0;
+  size_t  _cap = 0;
+};
+
+// Stand-in of the WiFiClient that counts the writes
+struct Client {
+  size_t  writes = 0;
+  size_t  bytes = 0;
+  void  write(const char* p, const size_t n) {
+    (void)p;
+    writes++;
+    bytes += n;
+  }
+};
+
+// WebServer::_prepareHeader
+void  sendHeader(Client& client, const char* contentType, const size_t contentLength) {
+  HostString  header;
+  header += "HTTP/1.1 200 OK\r\nContent-Type: ";
+  header += contentType;
+  header += "\r\n";
+  if (contentLength) {
+    header += "Content-Length: ";
+    header += static_cast<unsigned long>(contentLength);
+    header += "\r\n";
+  }
+  else
+    header += "Transfer-Encoding: chunked\r\n";
+  header += "Connection: close\r\n\r\n";
+  client.write(header.c_str(), header.length());
+}
+
+/**
+ * Port of EdgeChunkedResponse.
+ */
+class ChunkedResponse {
+ public:
+  explicit ChunkedResponse(Client& client) : _client(client) { sendHeader(_client, "application/json", 0); }
+  ~ChunkedResponse() {
+    _flush();
+    _client.write("0\r\n\r\n", 5);
+  }
+
+  void  write(const char* buffer, size_t size) {
+    while (size) {
+      if (_len >= sizeof(_buffer))
+        _flush();
+      size_t  len = std::min(size, sizeof(_buffer) - _len);
+      memcpy(_buffer + _len, buffer, len);
+      _len += len;
+      buffer += len;
+      size -= len;
+    }
+  }
+  void  write(const char* s) { write(s, strlen(s)); }
+
+ private:
+  // WebServer::sendContent writes the chunk size, the chunk and the footer.
+  void  _flush(void) {
+    if (_len) {
+      char  size[8];
+      _client.write(size, snprintf(size, sizeof(size), "%zx\r\n", _len));
+      _client.write(_buffer, _len);
+      _client.write("\r\n", 2);
+      _len = 0;
+    }
+  }
+
+  Client& _client;
+  char    _buffer[CHUNK_BUFFER_SIZE];
+  size_t  _len = 0;
+};
+
+// EdgeMQTT_t and the ACInput elements of mqtt_setting.json
+struct Field {
+  const char* name;
+  const char* label;
+  std::string value;
+  bool  number;
+};
+
+Field fields[] = {
+  { "server", "Server", "mqtt3.thingspeak.com", false },
+  { "apikey", "User API Key", "XXXXXXXXXXXXXXXX", false },
+  { "channelid", "Channel ID", "1234567", false },
+  { "writekey", "Write API Key", "YYYYYYYYYYYYYYYY", false },
+  { "clientid", "Client ID", "AbCdEfGhIjKlMnOpQrStUvW", false },
+  { "username", "Username", "AbCdEfGhIjKlMnOpQrStUvW", false },
+  { "password", "Password", "AbCdEfGhIjKlMnOpQrStUvWx", false },
+  { "hostname", "ESP host name", "esp-edge", false },
+  { "port", nullptr, "1883", true },
+  { "keepAlive", nullptr, "60", true },
+  { "publishInterval", nullptr, "15000", true }
+};
+
+// The elements render into the page as AutoConnectInput::toHTML does.
+void  page(Client& client) {
+  HostString  html;
+  for (const Field& field : fields) {
+    if (!field.label)
+      continue;
+    HostString  element;
+    element += "<label for=\"";
+    element += field.name;
+    element += "\">";
+    element += field.label;
+    element += "</label><input type=\"text\" id=\"";
+    element += field.name;
+    element += "\" name=\"";
+    element += field.name;
+    element += "\" value=\"";
+    element += field.value.c_str();
+    element += "\"><br>";
+    html += element;
+  }
+  sendHeader(client, "text/html", html.length());
+  for (size_t offset = 0; offset < html.length(); offset += TCP_MSS)
+    client.write(html.c_str() + offset, std::min(TCP_MSS, html.length() - offset));
+}
+
+// The serializer fills the document and serializeJson writes it out.
+void  rest(Client& client) {
+  void* doc = edAlloc(SERIALIZE_BUFFER_SIZE);
+  ChunkedResponse response(client);
+  char  dlm = '{';
+  for (const Field& field : fields) {
+    response.write(&dlm, 1);
+    response.write("\"");
+    response.write(field.name);
+    response.write(field.number ? "\":" : "\":\"");
+    response.write(field.value.c_str(), field.value.length());
+    if (!field.number)
+      response.write("\"");
+    dlm = ',';
+  }
+  response.write("}");
+  edFree(doc);
+}
+
+struct Result {
+  double  allocations;
+  long  peak;
+  double  writes;
+  double  bytes;
+  double  ns;
+};
+
+template<typename Respond>
+Result  measure(const size_t responses, Respond respond) {
+  Client  client;
+  allocations = 0;
+  live = peak = 0;
+  counting = true;
+  auto  start = std::chrono::steady_clock::now();
+  for (size_t n = 0; n < responses; n++)
+    respond(client);
+  auto  elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  counting = false;
+  return { static_cast<double>(allocations) / responses, peak, static_cast<double>(client.writes) / responses,
+    static_cast<double>(client.bytes) / responses, static_cast<double>(elapsed) / responses };
+}
+
+void  report(const char* label, const Result& result) {
+  printf("%-16s %12.1f %10ld %12.1f %10.0f %10.0f\n", label, result.allocations, result.peak, result.writes, result.bytes, result.ns);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+  void* p = edAlloc(size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return edAlloc(size); }
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void  operator delete(void* p) noexcept { edFree(p); }
+void  operator delete(void* p, size_t) noexcept { edFree(p); }
+void  operator delete[](void* p) noexcept { edFree(p); }
+void  operator delete[](void* p, size_t) noexcept { edFree(p); }
+
+int main(int argc, char* argv[]) {
+  size_t  responses = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+
+  printf("%-16s %12s %10s %12s %10s %10s\n", "response", "allocations", "peak heap", "client write", "bytes", "ns");
+  Result  pageResult = measure(responses, page);
+  Result  restResult = measure(responses, rest);
+  report("page", pageResult);
+  report("REST", restResult);
+
+  for (Field& field : fields)
+    if (!field.number)
+      field.value = field.value + field.value + field.value + field.value;
+  Result  pageLong = measure(responses, page);
+  Result  restLong = measure(responses, rest);
+  report("page, 4x values", pageLong);
+  report("REST, 4x values", restLong);
+
+  if (restLong.peak != restResult.peak) {
+    printf("FAIL: the peak heap of the REST response depends on the body\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,355 @@
+/**
+ *	Host soak test of EdgeBlockPool and the parking of the released pages.
+ *	@file	edauxpool_soak.cpp
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ *
+ * It cycles the join and release of the pages that EdgeDriverEnabler's
+ * driversProcess triggers 100k times on a simulated heap of the ESP8266
+ * size, and reports the fragmentation as the largest free block against
+ * the total free, and the heap allocations per cycle. Each cycle toggles
+ * the page of one of the drivers. The allocators are:
+ * - new/delete: the join loads a new page and the release deletes it, as
+ *   EdgeUnified did before the pool.
+ * - EdgeBlockPool: the page is placed in a block of the pool, but the
+ *   release destroys it, as ED_AUXPOOL_PARKS 0.
+ * - pool+parking: the model of EdgeUnified::release and _join with the
+ *   default ED_AUXPOOL_BLOCKS and ED_AUXPOOL_PARKS. The release parks the
+ *   loaded page, and the join of the same JSON description reuses it. The
+ *   reload of the reused page restores the values in its elements without
+ *   allocating them, so that the model omits it. The oldest parked page
+ *   beyond the parks is destroyed.
+ * The simulated heap is a first-fit allocator with the coalescing of the
+ * adjacent free blocks like umm_malloc, and the other allocations of the
+ * system such as the TCP buffers interleave with the pages.
+ *
+ * usage: edauxpool_soak [cycles]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <vector>
+#include "EdgeBlockPool.h"
+
+namespace {
+
+// Simulated heap
+const size_t  ARENA_SIZE = 24 * 1024;
+const size_t  ALIGN = 8;
+
+struct Block {
+  uint32_t  size;                                       /**< Size including the header */
+  uint32_t  used;                                       /**< The block is allocated */
+};
+
+alignas(ALIGN) uint8_t  arena[ARENA_SIZE];
+bool    arenaOn = false;
+size_t  arenaFailures = 0;
+size_t  arenaAllocs = 0;
+
+Block*  first(void) { return reinterpret_cast<Block*>(arena); }
+Block*  next(Block* block) { return reinterpret_cast<Block*>(reinterpret_cast<uint8_t*>(block) + block->size); }
+bool    inArena(void* p) { return p >= static_cast<void*>(arena) && p < static_cast<void*>(arena + ARENA_SIZE); }
+
+void  arenaReset(void) {
+  first()->size = ARENA_SIZE;
+  first()->used = 0;
+}
+
+void* arenaAlloc(size_t size) {
+  arenaAllocs++;
+  size_t  need = (size + sizeof(Block) + ALIGN - 1) & ~(ALIGN - 1);
+  for (Block* block = first(); reinterpret_cast<uint8_t*>(block) < arena + ARENA_SIZE; block = next(block)) {
+    if (block->used)
+      continue;
+    // Coalesces the following free blocks
+    Block*  following = next(block);
+    while (reinterpret_cast<uint8_t*>(following) < arena + ARENA_SIZE && !following->used) {
+      block->size += following->size;
+      following = next(block);
+    }
+    if (block->size >= need) {
+      if (block->size - need >= sizeof(Block) + ALIGN) {
+        Block*  rest = reinterpret_cast<Block*>(reinterpret_cast<uint8_t*>(block) + need);
+        rest->size = block->size - need;
+        rest->used = 0;
+        block->size = need;
+      }
+      block->used = 1;
+      return block + 1;
+    }
+  }
+  arenaFailures++;
+  return nullptr;
+}
+
+void  arenaFree(void* p) {
+  (reinterpret_cast<Block*>(p) - 1)->used = 0;
+}
+
+// Returns the total free and the largest free block, coalescing the
+// adjacent free blocks.
+void  arenaStats(size_t& total, size_t& largest) {
+  total = largest = 0;
+  for (Block* block = first(); reinterpret_cast<uint8_t*>(block) < arena + ARENA_SIZE; block = next(block)) {
+    if (block->used)
+      continue;
+    Block*  following = next(block);
+    while (reinterpret_cast<uint8_t*>(following) < arena + ARENA_SIZE && !following->used) {
+      block->size += following->size;
+      following = next(block);
+    }
+    total += block->size - sizeof(Block);
+    if (block->size - sizeof(Block) > largest)
+      largest = block->size - sizeof(Block);
+  }
+}
+
+// Deterministic pseudo random numbers
+uint32_t  seed;
+uint32_t  rnd(const uint32_t range) {
+  seed = seed * 1664525UL + 1013904223UL;
+  return (seed >> 8) % range;
+}
+
+/**
+ * Stand-in of AutoConnectAux. Its size is close to AutoConnectAux on
+ * ESP8266, and the load allocates the elements from the heap as the JSON
+ * description parser does.
+ */
+class StubAux {
+ public:
+  StubAux() { memset(_members, 0, sizeof(_members)); }
+  ~StubAux() {
+    for (char* element : _elements)
+      delete[] element;
+  }
+
+  void  load(void) {
+    _elements.reserve(6);
+    for (int n = 0; n < 6; n++)
+      _elements.push_back(new char[24 + rnd(96)]);
+  }
+
+ protected:
+  uint8_t _members[128];                                /**< uri, title, handler and so on */
+  std::vector<char*>  _elements;                        /**< Elements loaded from the JSON */
+};
+
+// Allocation of the system that lives across some cycles
+struct Transient {
+  char* p;
+  uint32_t  until;
+};
+
+struct Result {
+  size_t  total;
+  size_t  largest;
+  double  worst;
+  double  allocs;
+  size_t  failures;
+  bool    leaked;
+};
+
+// Drivers owning a page each, and the defaults of EdgeUnified
+const int PAGES = 6;
+const uint8_t AUXPOOL_BLOCKS = 8;
+const size_t  AUXPOOL_PARKS = 4;
+
+template<typename Join, typename Release, typename Finish>
+Result  soak(const uint32_t cycles, Join join, Release release, Finish finish) {
+  Result  result = { 0, 0, 1.0, 0.0, 0, false };
+  std::vector<Transient>  transients;
+  StubAux*  pages[PAGES] = { nullptr };
+
+  seed = 12345;
+  arenaReset();
+  arenaFailures = 0;
+  arenaOn = true;
+  size_t  initial, largest;
+  arenaStats(initial, largest);
+  transients.reserve(64);
+  size_t  allocs = 0;
+
+  for (uint32_t cycle = 0; cycle < cycles; cycle++) {
+    // driversProcess joins or releases the page of a driver
+    int page = rnd(PAGES);
+    size_t  mark = arenaAllocs;
+    if (pages[page]) {
+      release(page, pages[page]);
+      pages[page] = nullptr;
+    }
+    else
+      pages[page] = join(page);
+    allocs += arenaAllocs - mark;
+
+    // Other allocations of the system interleave
+    for (uint32_t n = rnd(3); n > 0; n--) {
+      if (transients.size() < transients.capacity()) {
+        char* p = new (std::nothrow) char[16 + rnd(240)];
+        if (p)
+          transients.push_back({ p, cycle + 1 + rnd(50) });
+      }
+    }
+    for (size_t n = 0; n < transients.size();) {
+      if (transients[n].until <= cycle) {
+        delete[] transients[n].p;
+        transients[n] = transients.back();
+        transients.pop_back();
+      }
+      else
+        n++;
+    }
+
+    if (cycle % 100 == 99) {
+      size_t  total;
+      arenaStats(total, largest);
+      double  ratio = total ? static_cast<double>(largest) / total : 1.0;
+      if (ratio < result.worst)
+        result.worst = ratio;
+    }
+  }
+
+  arenaStats(result.total, result.largest);
+  result.failures = arenaFailures;
+  result.allocs = cycles ? static_cast<double>(allocs) / cycles : 0.0;
+
+  // Everything released must return the heap to the initial state.
+  for (int page = 0; page < PAGES; page++)
+    if (pages[page])
+      release(page, pages[page]);
+  for (Transient& transient : transients)
+    delete[] transient.p;
+  transients.clear();
+  transients.shrink_to_fit();
+  finish();
+  size_t  remain;
+  arenaStats(remain, largest);
+  result.leaked = remain != initial;
+  arenaOn = false;
+  return result;
+}
+
+void  report(const char* label, const Result& result) {
+  printf("%-14s %10zu %12zu %8.3f %12.3f %12.2f %9zu\n", label, result.total, result.largest,
+    result.total ? static_cast<double>(result.largest) / result.total : 1.0, result.worst, result.allocs, result.failures);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+  void* p = arenaOn ? arenaAlloc(size) : malloc(size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return arenaOn ? arenaAlloc(size) : malloc(size);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+void  operator delete(void* p) noexcept {
+  if (inArena(p))
+    arenaFree(p);
+  else
+    free(p);
+}
+
+void  operator delete(void* p, size_t) noexcept { operator delete(p); }
+void  operator delete[](void* p) noexcept { operator delete(p); }
+void  operator delete[](void* p, size_t) noexcept { operator delete(p); }
+
+int main(int argc, char* argv[]) {
+  uint32_t  cycles = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+
+  printf("%u join/release cycles of %d pages, heap %zu bytes, page %zu bytes\n", cycles, PAGES, ARENA_SIZE, sizeof(StubAux));
+  printf("%-14s %10s %12s %8s %12s %12s %9s\n", "allocator", "total free", "largest free", "ratio", "worst ratio", "allocs/cycle", "failures");
+
+  Result  plain = soak(cycles, [](int) {
+    StubAux*  aux = new (std::nothrow) StubAux;
+    if (aux)
+      aux->load();
+    return aux;
+  }, [](int, StubAux* aux) { delete aux; }, []() {});
+  report("new/delete", plain);
+
+  // The pool is created in the first join as EdgeUnified does.
+  EdgeBlockPool<StubAux>* pool = nullptr;
+  bool  remained = false;
+  Result  pooled = soak(cycles, [&](int) {
+    if (!pool)
+      pool = new EdgeBlockPool<StubAux>(AUXPOOL_BLOCKS);
+    StubAux*  aux = pool->create();
+    aux->load();
+    return aux;
+  }, [&](int, StubAux* aux) { pool->destroy(aux); }, [&]() {
+    remained |= pool && pool->inUse();
+    delete pool;
+    pool = nullptr;
+  });
+  report("EdgeBlockPool", pooled);
+
+  // The released page is parked with the fingerprint of its JSON, which
+  // is the page number here.
+  struct Parked {
+    int page;
+    StubAux*  aux;
+  };
+  std::deque<Parked>* parked = nullptr;
+  size_t  reused = 0;
+  Result  parking = soak(cycles, [&](int page) {
+    if (!pool) {
+      pool = new EdgeBlockPool<StubAux>(AUXPOOL_BLOCKS);
+      parked = new std::deque<Parked>;
+    }
+    for (std::deque<Parked>::iterator it = parked->begin(); it != parked->end(); ++it) {
+      if (it->page == page) {
+        StubAux*  aux = it->aux;
+        parked->erase(it);
+        reused++;
+        return aux;
+      }
+    }
+    StubAux*  aux = pool->create();
+    aux->load();
+    return aux;
+  }, [&](int page, StubAux* aux) {
+    parked->push_back({ page, aux });
+    while (parked->size() > AUXPOOL_PARKS) {
+      pool->destroy(parked->front().aux);
+      parked->pop_front();
+    }
+  }, [&]() {
+    // ~EdgeUnified destroys the parked pages
+    for (Parked& entry : *parked)
+      pool->destroy(entry.aux);
+    delete parked;
+    remained |= pool && pool->inUse();
+    delete pool;
+    pool = nullptr;
+  });
+  report("pool+parking", parking);
+  printf("%zu of %u joins reused a parked page\n", reused, (cycles + 1) / 2);
+
+  if (remained) {
+    printf("FAIL: blocks of EdgeBlockPool remain in use\n");
+    return 1;
+  }
+  if (plain.leaked || pooled.leaked || parking.leaked) {
+    printf("FAIL: the heap has leaked\n");
+    return 1;
+  }
+  if (pooled.failures || parking.failures) {
+    printf("FAIL: allocations failed with EdgeBlockPool\n");
+    return 1;
+  }
+  return 0;
+}
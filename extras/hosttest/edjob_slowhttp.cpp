@@ -0,0 +1,284 @@
+/**
+ *	Host test of the sliced job against a slow HTTP server.
+ *	@file	edjob_slowhttp.cpp
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ *
+ * It runs the channel clear job of the yamqtt example as EdgeUnified::
+ * process runs the jobs, one step of the head job per turn, against an HTTP
+ * stand-in on a loopback port that injects the slow responses. The steps of
+ * the job are those of ClearChannel on ESP32 with the POSIX sockets, which
+ * the lwip_ functions mirror. The loop stands in for the other EdgeDrivers
+ * and the web server, and the test fails if any turn is blocked longer
+ * than 5 ms, or if the job does not end with the expected result.
+ * The stand-in answers each connection in the manner of the scenario:
+ * - slow:     waits 1.5 s, then trickles the response 1 byte every 20 ms.
+ * - silent:   accepts and reads the request but never responds.
+ * - refused:  nothing listens on the port.
+ * The timeouts of the job are shortened from those of the example to keep
+ * the test short.
+ *
+ * usage: edjob_slowhttp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// Same values as EdgeUnified.h and ESP8266HTTPClient
+const int ED_JOB_CONTINUE = -2147483647 - 1;
+const int HTTPC_ERROR_CONNECTION_FAILED = -1;
+const int HTTPC_ERROR_CONNECTION_LOST = -5;
+const int HTTPC_ERROR_NO_HTTP_SERVER = -7;
+const int HTTPC_ERROR_READ_TIMEOUT = -11;
+
+const unsigned long CLEAR_CONNECT_TIMEOUT = 1000;
+const unsigned long CLEAR_RESPONSE_TIMEOUT = 3000;
+const unsigned long TURN_LIMIT = 5000;              // [us]
+
+unsigned long millis(void) {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+unsigned long micros(void) {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+enum Scenario { SLOW, SILENT };
+
+/**
+ * HTTP stand-in that answers in the manner of the scenario.
+ */
+class SlowHTTP {
+ public:
+  explicit SlowHTTP(const Scenario scenario) : _scenario(scenario), _stop(false) {
+    _listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(_listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(_listener, reinterpret_cast<sockaddr*>(&addr), &len);
+    port = ntohs(addr.sin_port);
+    listen(_listener, 4);
+    _thread = std::thread([this]() { _serve(); });
+  }
+
+  ~SlowHTTP() {
+    _stop = true;
+    _thread.join();
+    close(_listener);
+  }
+
+  uint16_t  port;
+
+ protected:
+  void  _serve(void) {
+    while (!_stop) {
+      pollfd  pfd = { _listener, POLLIN, 0 };
+      if (poll(&pfd, 1, 10) <= 0)
+        continue;
+      int fd = accept(_listener, nullptr, nullptr);
+      if (fd < 0)
+        continue;
+      char  req[512];
+      if (read(fd, req, sizeof(req)) > 0 && _scenario == SLOW) {
+        _sleep(1500);
+        const char* res = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        for (const char* p = res; *p && !_stop; p++) {
+          if (write(fd, p, 1) != 1)
+            break;
+          _sleep(20);
+        }
+      }
+      while (!_stop) {
+        pollfd  rfd = { fd, POLLIN, 0 };
+        if (poll(&rfd, 1, 10) > 0 && read(fd, req, sizeof(req)) <= 0)
+          break;
+      }
+      close(fd);
+    }
+  }
+
+  void  _sleep(const unsigned long ms) {
+    unsigned long tm = millis();
+    while (!_stop && millis() - tm < ms)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  Scenario  _scenario;
+  int _listener;
+  std::atomic<bool> _stop;
+  std::thread _thread;
+};
+
+/**
+ * Steps of ClearChannel of the yamqtt example on ESP32.
+ */
+class ClearChannel {
+ public:
+  ClearChannel(const uint16_t port, const std::string& path) : _port(port), _path(path) {}
+  ~ClearChannel() {
+    if (_fd >= 0)
+      close(_fd);
+  }
+
+  int step(void) {
+    switch (_state) {
+    case BEGIN:
+      _tm = millis();
+      if (!_connect())
+        return HTTPC_ERROR_CONNECTION_FAILED;
+      _state = CONNECTING;
+      break;
+
+    case CONNECTING: {
+      int rc = _connected();
+      if (rc < 0 || (!rc && millis() - _tm > CLEAR_CONNECT_TIMEOUT))
+        return HTTPC_ERROR_CONNECTION_FAILED;
+      if (rc) {
+        std::string req = "DELETE " + _path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+        if (write(_fd, req.data(), req.size()) != static_cast<ssize_t>(req.size()))
+          return HTTPC_ERROR_CONNECTION_LOST;
+        _tm = millis();
+        _state = RESPONDING;
+      }
+      break;
+    }
+
+    case RESPONDING:
+      // WiFiClient::available and read do not block.
+      for (;;) {
+        char  c;
+        ssize_t n = recv(_fd, &c, 1, MSG_DONTWAIT);
+        if (n == 0)
+          return HTTPC_ERROR_CONNECTION_LOST;
+        if (n < 0)
+          break;
+        if (c == '\n') {
+          size_t  sp = _line.find(' ');
+          return sp != std::string::npos ? atoi(_line.c_str() + sp + 1) : HTTPC_ERROR_NO_HTTP_SERVER;
+        }
+        if (c != '\r' && _line.length() < 64)
+          _line += c;
+      }
+      if (millis() - _tm > CLEAR_RESPONSE_TIMEOUT)
+        return HTTPC_ERROR_READ_TIMEOUT;
+      break;
+    }
+    return ED_JOB_CONTINUE;
+  }
+
+ private:
+  bool  _connect(void) {
+    _fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (_fd < 0)
+      return false;
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(_port);
+    return connect(_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 || errno == EINPROGRESS;
+  }
+
+  // Returns 1 when connected, 0 while connecting and -1 if failed.
+  int _connected(void) {
+    fd_set  fdset;
+    timeval tv = { 0, 0 };
+    FD_ZERO(&fdset);
+    FD_SET(_fd, &fdset);
+    int rc = select(_fd + 1, nullptr, &fdset, nullptr, &tv);
+    if (rc <= 0)
+      return rc;
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err)
+      return -1;
+    return 1;
+  }
+
+  enum { BEGIN, CONNECTING, RESPONDING } _state = BEGIN;
+  uint16_t  _port;
+  std::string _path;
+  std::string _line;
+  int _fd = -1;
+  unsigned long _tm = 0;
+};
+
+/**
+ * Runs the job as EdgeUnified::process does, one step per turn, with the
+ * other work of the loop in between.
+ */
+bool run(const char* name, const uint16_t port, const int expected) {
+  std::deque<std::function<int(void)>>  jobs;
+  std::shared_ptr<ClearChannel> clear = std::make_shared<ClearChannel>(port, "/channels/1234567/feeds.json?api_key=KEY");
+  jobs.push_back([clear]() { return clear->step(); });
+
+  const unsigned long start = millis();
+  unsigned long turns = 0;
+  unsigned long worst = 0;
+  int result = ED_JOB_CONTINUE;
+  while (jobs.size()) {
+    unsigned long tm = micros();
+    result = jobs.front()();
+    if (result != ED_JOB_CONTINUE)
+      jobs.pop_front();
+    worst = std::max(worst, micros() - tm);
+    turns++;
+    // The other EdgeDrivers and the web server
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+
+  bool  rc = result == expected && worst < TURN_LIMIT;
+  printf("%-8s %8d %10lu %10lu %12lu %s\n", name, result, millis() - start, turns, worst, rc ? "" : "FAIL");
+  return rc;
+}
+
+}  // namespace
+
+int main(void) {
+  bool  rc = true;
+
+  printf("%-8s %8s %10s %10s %12s\n", "server", "result", "done [ms]", "turns", "max turn[us]");
+  {
+    SlowHTTP  http(SLOW);
+    rc &= run("slow", http.port, 200);
+  }
+  {
+    SlowHTTP  http(SILENT);
+    rc &= run("silent", http.port, HTTPC_ERROR_READ_TIMEOUT);
+  }
+  {
+    // The port of the closed stand-in refuses the connection.
+    uint16_t  port;
+    {
+      SlowHTTP  http(SILENT);
+      port = http.port;
+    }
+    rc &= run("refused", port, HTTPC_ERROR_CONNECTION_FAILED);
+  }
+  return rc ? 0 : 1;
+}
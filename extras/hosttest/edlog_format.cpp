@@ -0,0 +1,93 @@
+/**
+ *	Host test of the argument packing of the deferred ED_DBG.
+ *	@file	edlog_format.cpp
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ *
+ * It packs the arguments of the format strings into EdgeLogArgs as the
+ * deferred ED_DBG does at the call, formats them back as the drain does,
+ * and compares the result with vsnprintf of the same arguments. The cases
+ * cover the width and the precision given by `*`, which take the int
+ * argument before the value, and check that the arguments after them are
+ * not shifted. The arguments that do not fit are checked to be left as
+ * the conversion specification.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "EdgeLogArgs.h"
+
+namespace {
+
+// Same size as the default ED_DEBUG_ARGS_SIZE
+EdgeLogArgs<32> args;
+unsigned long failures = 0;
+
+std::string deferred(const char* fmt, va_list ap) {
+  char  line[128];
+  args.clear();
+  args.pack(fmt, ap);
+  args.format(line, sizeof(line), fmt);
+  return line;
+}
+
+void expect(const char* fmt, ...) {
+  va_list ap;
+  char  line[128];
+
+  va_start(ap, fmt);
+  vsnprintf(line, sizeof(line), fmt, ap);
+  va_end(ap);
+  va_start(ap, fmt);
+  std::string result = deferred(fmt, ap);
+  va_end(ap);
+
+  if (result != line) {
+    printf("FAIL: \"%s\" gave \"%s\", expected \"%s\"\n", fmt, result.c_str(), line);
+    failures++;
+  }
+}
+
+void expectTruncated(const char* expected, const char* fmt, ...) {
+  va_list ap;
+
+  va_start(ap, fmt);
+  std::string result = deferred(fmt, ap);
+  va_end(ap);
+
+  if (result != expected || !args.truncated()) {
+    printf("FAIL: \"%s\" gave \"%s\", expected \"%s\" truncated\n", fmt, result.c_str(), expected);
+    failures++;
+  }
+}
+
+}  // namespace
+
+int main(void) {
+  expect("plain\n");
+  expect("%d %u %x %%\n", -42, 42u, 0xedu);
+  expect("%ld %lu %lld %llu\n", -7L, 7UL, -1234567890123LL, 9876543210ULL);
+  expect("%zu bytes\n", static_cast<size_t>(4096));
+  expect("%c%c %s\n", 'E', 'D', "edge");
+  expect("%.2f %e %g\n", 3.14159, 2.5e-3, 100.0);
+
+  // The width and the precision given by the arguments
+  expect("[%*d]\n", 6, 42);
+  expect("[%-*d|%u]\n", 6, -42, 7u);
+  expect("[%.*s] %d\n", 3, "truncated", 9);
+  expect("[%*.*s] %d\n", 8, 2, "abcdef", 10);
+  expect("[%*.*f] %s\n", 9, 3, 2.718281828, "after");
+  expect("[%0*lld] %x\n", 12, -5LL, 0xbeefu);
+  expect("%s=%*d, %s=%.*s\n", "a", 4, 1, "b", 1, "xyz");
+
+  // The arguments beyond the size are left as the specification
+  expectTruncated("0123456789012345678901234567890 %d\n", "%s %d\n", "0123456789012345678901234567890123456789", 1);
+  expectTruncated("1 2 3 4 5 6 7 8 %*d\n", "%d %d %d %d %d %d %d %d %*d\n", 1, 2, 3, 4, 5, 6, 7, 8, 3, 9);
+
+  printf("%lu failures\n", failures);
+  return failures ? 1 : 0;
+}
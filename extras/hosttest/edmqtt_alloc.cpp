@@ -0,0 +1,178 @@
+/**
+ *	Host benchmark of the payload and the queue of EdgeMQTTDriver.
+ *	@file	edmqtt_alloc.cpp
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ *
+ * It runs the steady state of the publish handler of EdgeMQTTDriver, which
+ * formats the fields into EdgeMQTTPayload and queues the message into
+ * EdgeMQTTQueue, while the flush drains the queue in batches as the session
+ * comes and goes. The backlog is also walked by the offsets as the spool
+ * before the deep sleep does. It counts the heap allocations made by
+ * operator new and malloc after the warm-up, and fails unless there is
+ * none. It also checks that the drained messages come out intact and in
+ * order.
+ *
+ * usage: edmqtt_alloc [messages]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "EdgeMQTTBuffer.h"
+
+namespace {
+
+// Same sizes as the default of EdgeMQTTDriver
+const size_t  PAYLOAD_SIZE = 128;                       // ED_MQTT_PAYLOAD_SIZE
+const size_t  QUEUE_SIZE = 2048;                        // ED_MQTT_QUEUE_SIZE
+const size_t  MESSAGE_SIZE = 256;                       // ED_MQTT_MESSAGE_SIZE
+const size_t  FLUSH_BATCH = 8;                          // ED_MQTT_FLUSH_BATCH
+
+bool  counting = false;
+unsigned long allocations = 0;
+
+// Counts the allocation of operator new unless malloc counts it.
+void  countNew(void) {
+#if !defined(__GLIBC__)
+  if (counting)
+    allocations++;
+#endif
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+  countNew();
+  void* p = malloc(size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  countNew();
+  return malloc(size);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void  operator delete(void* p) noexcept { free(p); }
+void  operator delete(void* p, size_t) noexcept { free(p); }
+void  operator delete[](void* p) noexcept { free(p); }
+void  operator delete[](void* p, size_t) noexcept { free(p); }
+
+#if defined(__GLIBC__)
+// The C library allocations such as the ones snprintf might make are
+// counted by interposing malloc.
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+
+void* malloc(size_t size) {
+  if (counting)
+    allocations++;
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+  if (counting)
+    allocations++;
+  return __libc_calloc(n, size);
+}
+
+void* realloc(void* p, size_t size) {
+  if (counting)
+    allocations++;
+  return __libc_realloc(p, size);
+}
+}
+#endif
+
+int main(int argc, char* argv[]) {
+  unsigned long messages = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+  static EdgeMQTTPayload<PAYLOAD_SIZE>  payload;
+  static EdgeMQTTQueue<QUEUE_SIZE>  queue;
+  static uint8_t  message[MESSAGE_SIZE];
+  const char* topic = "channels/1234567/publish";
+  const size_t  tLen = strlen(topic);
+  unsigned long queued = 0;
+  unsigned long flushed = 0;
+  unsigned long full = 0;
+  unsigned long broken = 0;
+  long  last = -1;
+
+  auto  publish = [&](const unsigned long seq) {
+    payload.field(1, static_cast<long>(seq));
+    payload.field(2, -64 + static_cast<int>(seq % 32));
+    payload.field(3, 21.5 + (seq % 100) / 10.0);
+    payload.field(4, (seq & 1) ? "on" : "off");
+    if (queue.push(topic, tLen, payload.c_str(), payload.length()))
+      queued++;
+    else
+      full++;
+    payload.clear();
+  };
+  auto  flush = [&]() {
+    size_t  t, p;
+    for (size_t n = 0; n < FLUSH_BATCH && queue.peek(message, sizeof(message), t, p); n++) {
+      // The message carries the sequence in field1 and comes out in order.
+      const char* body = reinterpret_cast<const char*>(message + tLen + 1);
+      long  seq = p > 7 && !memcmp(body, "field1=", 7) ? strtol(body + 7, nullptr, 10) : -1;
+      if (t != tLen || memcmp(message, topic, tLen) || message[tLen] || seq <= last || (memcmp(body + p - 2, "on", 2) && memcmp(body + p - 3, "off", 3)))
+        broken++;
+      last = seq;
+      queue.pop();
+      flushed++;
+    }
+  };
+
+  // Warm-up lets the C library set up its buffers.
+  publish(0);
+  flush();
+  queued = flushed = full = 0;
+  last = -1;
+
+  counting = true;
+  auto  start = std::chrono::steady_clock::now();
+  for (unsigned long seq = 0; seq < messages; seq++) {
+    publish(seq);
+    // The session is down for 1000 messages in every 2000, so the queue
+    // fills up and wraps around.
+    if ((seq / 1000) % 2 == 0) {
+      if (seq % 1000 == 0) {
+        // The offsets walk the backlog as the spool before the deep sleep does.
+        size_t  offset = 0, count = 0, t, p;
+        while (queue.peek(message, sizeof(message), t, p, offset)) {
+          offset += queue.HEADER_SIZE + t + p;
+          count++;
+        }
+        if (count != queue.count() || offset != queue.used())
+          broken++;
+      }
+      flush();
+    }
+  }
+  while (queue.count())
+    flush();
+  auto  elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  counting = false;
+
+  printf("%lu messages, %lu queued, %lu flushed, %lu refused by the full queue\n", messages, queued, flushed, full);
+  printf("%.1f ns per message, %lu heap allocations\n", static_cast<double>(elapsed) / messages, allocations);
+
+  if (broken) {
+    printf("FAIL: %lu messages came out broken or out of order\n", broken);
+    return 1;
+  }
+  if (allocations) {
+    printf("FAIL: the steady state allocated the heap\n");
+    return 1;
+  }
+  return 0;
+}
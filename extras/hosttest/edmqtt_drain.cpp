@@ -0,0 +1,169 @@
+/**
+ *	Host benchmark of draining the offline backlog of EdgeMQTTDriver.
+ *	@file	edmqtt_drain.cpp
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ *
+ * While the broker is down, the messages are queued as EdgeMQTTDriver::
+ * enqueue does, into EdgeMQTTQueue until it is full and then into the spool
+ * file in the same record form. Once the session is up, the turns flush the
+ * backlog as EdgeMQTTDriver::_flush does, the RAM queue first and then the
+ * spool, up to the batch per turn with the spool opened and closed in each
+ * turn. It reports the drain throughput to the local broker stand-in of
+ * edmqtt_standin.h for several batch sizes, and fails unless every message
+ * arrives once and in order. The spool is a file of the host file system,
+ * which is much faster than the flash of the device.
+ *
+ * usage: edmqtt_drain [messages]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "EdgeMQTTBuffer.h"
+#include "edmqtt_standin.h"
+
+namespace {
+
+// Same sizes as the default of EdgeMQTTDriver
+const size_t  PAYLOAD_SIZE = 128;
+const size_t  QUEUE_SIZE = 2048;
+const size_t  MESSAGE_SIZE = 256;
+const char* topic = "channels/1234567/publish";
+const char* spoolFile = "edmqtt_drain.spl";
+
+EdgeMQTTPayload<PAYLOAD_SIZE> payload;
+EdgeMQTTQueue<QUEUE_SIZE> queue;
+uint8_t message[MESSAGE_SIZE];
+size_t  spoolCount;
+size_t  spoolRead;
+
+// Queues the messages while the session is down
+void backlog(const size_t messages) {
+  const size_t  tLen = strlen(topic);
+  FILE* spool = fopen(spoolFile, "wb");
+
+  queue.clear();
+  spoolCount = spoolRead = 0;
+  for (size_t seq = 0; seq < messages; seq++) {
+    payload.clear();
+    payload.field(1, static_cast<long>(seq));
+    payload.field(2, -64 + static_cast<int>(seq % 32));
+    payload.field(3, 21.5 + (seq % 100) / 10.0);
+    const size_t  pLen = payload.length();
+    if (!spoolCount && queue.push(topic, tLen, payload.c_str(), pLen))
+      continue;
+    const uint8_t header[EdgeMQTTQueue<QUEUE_SIZE>::HEADER_SIZE] = {
+      static_cast<uint8_t>(tLen), static_cast<uint8_t>(tLen >> 8),
+      static_cast<uint8_t>(pLen), static_cast<uint8_t>(pLen >> 8)
+    };
+    fwrite(header, 1, sizeof(header), spool);
+    fwrite(topic, 1, tLen, spool);
+    fwrite(payload.c_str(), 1, pLen, spool);
+    spoolCount++;
+  }
+  fclose(spool);
+}
+
+// A turn of the process that flushes up to the batch
+bool flush(EdgeMQTTHostClient& client, const size_t batch) {
+  FILE* spool = nullptr;
+  uint8_t header[EdgeMQTTQueue<QUEUE_SIZE>::HEADER_SIZE];
+
+  for (size_t n = 0; n < batch; n++) {
+    size_t  tLen, pLen;
+    if (queue.count()) {
+      if (!queue.peek(message, sizeof(message), tLen, pLen))
+        return false;
+    }
+    else if (spoolCount) {
+      if (!spool) {
+        spool = fopen(spoolFile, "rb");
+        if (!spool || fseek(spool, spoolRead, SEEK_SET))
+          return false;
+      }
+      bool  valid = fread(header, 1, sizeof(header), spool) == sizeof(header);
+      tLen = header[0] | (header[1] << 8);
+      pLen = header[2] | (header[3] << 8);
+      valid = valid && tLen + pLen + 1 <= sizeof(message);
+      valid = valid && fread(message, 1, tLen, spool) == tLen;
+      valid = valid && fread(message + tLen + 1, 1, pLen, spool) == pLen;
+      if (!valid)
+        return false;
+    }
+    else
+      break;
+
+    message[tLen] = '\0';
+    if (!client.publish(reinterpret_cast<const char*>(message), reinterpret_cast<const char*>(message) + tLen + 1, pLen))
+      return false;
+    if (queue.count())
+      queue.pop();
+    else {
+      spoolRead += sizeof(header) + tLen + pLen;
+      spoolCount--;
+    }
+  }
+  if (spool)
+    fclose(spool);
+  return true;
+}
+
+bool drain(const size_t messages, const size_t batch, const bool noDelay) {
+  EdgeMQTTBroker  broker(messages);
+  EdgeMQTTHostClient  client;
+
+  backlog(messages);
+  const size_t  queued = queue.count();
+  const size_t  spooled = spoolCount;
+  if (!client.connect(broker.port, "edge", noDelay))
+    return false;
+
+  const int64_t start = edNow();
+  size_t  turns = 0;
+  bool  rc = true;
+  while (rc && (queue.count() || spoolCount)) {
+    rc = flush(client, batch);
+    turns++;
+  }
+  const int64_t flushed = edNow();
+  rc = rc && broker.wait(messages);
+  int64_t last = 0;
+  for (int64_t tm : broker.arrivals)
+    last = std::max(last, tm);
+  client.disconnect();
+
+  // Every sequence arrives once and in order.
+  size_t  missing = 0;
+  size_t  disorder = 0;
+  for (size_t seq = 0; seq < messages; seq++) {
+    if (!broker.arrivals[seq])
+      missing++;
+    else if (seq && broker.arrivals[seq] < broker.arrivals[seq - 1])
+      disorder++;
+  }
+  rc = rc && !missing && !disorder && broker.received.load() == messages;
+
+  printf("%6zu %8s %7zu %8zu %7zu %10.1f %10.1f %12.0f\n", batch, noDelay ? "on" : "off", queued, spooled, turns,
+    (flushed - start) / 1e6, (last - start) / 1e6, messages / ((last - start) / 1e9));
+  if (!rc)
+    printf("FAIL: %zu received, %zu missing, %zu out of order\n", broker.received.load(), missing, disorder);
+  return rc;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t  messages = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000;
+  bool  rc = true;
+
+  printf("%6s %8s %7s %8s %7s %10s %10s %12s\n", "batch", "nodelay", "queued", "spooled", "turns", "flush [ms]", "drain [ms]", "messages/s");
+  for (size_t batch : { 1, 8, 32 }) {
+    rc &= drain(messages, batch, false);
+    rc &= drain(messages, batch, true);
+  }
+  remove(spoolFile);
+  return rc ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+/**
+ *	Host benchmark of the persistent MQTT session against the connection
+ *	per publish.
+ *	@file	edmqtt_publish.cpp
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ *
+ * It publishes to the local broker stand-in of edmqtt_standin.h in four
+ * ways and reports the publishes per second and the latency from the
+ * publish to the arrival at the broker.
+ * - connect/publish/disconnect: the processMQTT of the examples before
+ *   EdgeMQTTDriver, which opens the TCP connection and the MQTT session for
+ *   each message.
+ * - persistent session: EdgeMQTTDriver, whose publish handler formats the
+ *   payload into EdgeMQTTPayload and queues it into EdgeMQTTQueue, and the
+ *   turn flushes the queue over the session kept open. It runs flat out.
+ * - persistent session, 1 ms pace: the same at 1000 publishes/s, which
+ *   shows the latency without the backlog in the socket.
+ * - persistent session, 1 ms pace, nodelay: the same with the Nagle
+ *   algorithm disabled as the yamqtt example does on the connection.
+ * The loopback has no round trip of the WiFi, so the cost of the connection
+ * per publish appears far smaller than on the device.
+ *
+ * usage: edmqtt_publish [messages]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "EdgeMQTTBuffer.h"
+#include "edmqtt_standin.h"
+
+namespace {
+
+// Same sizes as the default of EdgeMQTTDriver
+const size_t  PAYLOAD_SIZE = 128;
+const size_t  QUEUE_SIZE = 2048;
+const size_t  MESSAGE_SIZE = 256;
+const size_t  FLUSH_BATCH = 8;
+const char* topic = "channels/1234567/publish";
+
+EdgeMQTTPayload<PAYLOAD_SIZE> payload;
+EdgeMQTTQueue<QUEUE_SIZE> queue;
+uint8_t message[MESSAGE_SIZE];
+
+void format(const size_t seq) {
+  payload.clear();
+  payload.field(1, static_cast<long>(seq));
+  payload.field(2, -64 + static_cast<int>(seq % 32));
+  payload.field(3, 21.5 + (seq % 100) / 10.0);
+}
+
+bool report(const char* name, EdgeMQTTBroker& broker, const std::vector<int64_t>& sent, const int64_t start) {
+  const size_t  messages = sent.size();
+  bool  arrived = broker.wait(messages);
+  int64_t last = 0;
+  for (int64_t tm : broker.arrivals)
+    last = std::max(last, tm);
+  double  elapsed = (last - start) / 1e9;
+  printf("%-40s %8zu %10.0f %10.1f %10.1f %10.1f %9zu\n", name, broker.received.load(), messages / elapsed,
+    edPercentile(sent, broker.arrivals, 50), edPercentile(sent, broker.arrivals, 99), edPercentile(sent, broker.arrivals, 100), broker.sessions.load());
+  if (!arrived)
+    printf("FAIL: %zu of %zu messages arrived\n", broker.received.load(), messages);
+  return arrived;
+}
+
+// Connection per publish as processMQTT of the examples did
+bool perPublish(const size_t messages) {
+  EdgeMQTTBroker  broker(messages);
+  std::vector<int64_t>  sent(messages);
+  const int64_t start = edNow();
+
+  for (size_t seq = 0; seq < messages; seq++) {
+    sent[seq] = edNow();
+    EdgeMQTTHostClient  client;
+    if (!client.connect(broker.port, "edge"))
+      break;
+    format(seq);
+    client.publish(topic, payload.c_str(), payload.length());
+    client.disconnect();
+  }
+  return report("connect/publish/disconnect", broker, sent, start);
+}
+
+// The session kept open by EdgeMQTTDriver, with the enqueue and the flush
+bool persistent(const char* name, const size_t messages, const int64_t pace, const bool noDelay) {
+  EdgeMQTTBroker  broker(messages);
+  EdgeMQTTHostClient  client;
+  std::vector<int64_t>  sent(messages);
+  const size_t  tLen = strlen(topic);
+
+  if (!client.connect(broker.port, "edge", noDelay))
+    return false;
+  const int64_t start = edNow();
+  size_t  seq = 0;
+  while (seq < messages || queue.count()) {
+    if (seq < messages && edNow() - start >= static_cast<int64_t>(seq) * pace) {
+      sent[seq] = edNow();
+      format(seq);
+      if (queue.push(topic, tLen, payload.c_str(), payload.length()))
+        seq++;
+    }
+    size_t  t, p;
+    for (size_t n = 0; n < FLUSH_BATCH && queue.peek(message, sizeof(message), t, p); n++) {
+      if (!client.publish(reinterpret_cast<const char*>(message), reinterpret_cast<const char*>(message) + t + 1, p))
+        return false;
+      queue.pop();
+    }
+  }
+  bool  rc = report(name, broker, sent, start);
+  client.disconnect();
+  return rc;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t  messages = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+  bool  rc = true;
+
+  printf("%-40s %8s %10s %10s %10s %10s %9s\n", "", "messages", "publish/s", "p50 [us]", "p99 [us]", "max [us]", "sessions");
+  rc &= perPublish(std::min<size_t>(messages, 2000));
+  rc &= persistent("persistent session", messages, 0, false);
+  rc &= persistent("persistent session, 1 ms pace", std::min<size_t>(messages, 2000), 1000000, false);
+  rc &= persistent("persistent session, 1 ms pace, nodelay", std::min<size_t>(messages, 2000), 1000000, true);
+  return rc ? 0 : 1;
+}
@@ -0,0 +1,279 @@
+/**
+ *	Local MQTT broker stand-in and client for the host benchmarks.
+ *	@file	edmqtt_standin.h
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ *
+ * EdgeMQTTBroker is a broker stand-in that listens on a port of the
+ * loopback interface. It serves one session at a time, answers CONNECT and
+ * PINGREQ, and stamps the arrival of each PUBLISH whose payload begins with
+ * `field1=<sequence>`. EdgeMQTTHostClient writes the MQTT 3.1.1 packets of
+ * QoS 0 as PubSubClient does, one write per packet from its buffer, over a
+ * blocking socket that keeps the Nagle algorithm of the stack unless the
+ * no-delay is given.
+ */
+
+#ifndef _EDMQTT_STANDIN_H_
+#define _EDMQTT_STANDIN_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+inline int64_t edNow(void) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class EdgeMQTTBroker {
+ public:
+  /**
+   * @param  messages  Number of the sequences whose arrival is stamped.
+   */
+  explicit EdgeMQTTBroker(const size_t messages) : arrivals(messages, 0), received(0), sessions(0), _stop(false) {
+    _listener = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(_listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(_listener, reinterpret_cast<sockaddr*>(&addr), &len);
+    port = ntohs(addr.sin_port);
+    listen(_listener, 64);
+    _thread = std::thread([this]() { _serve(); });
+  }
+
+  ~EdgeMQTTBroker() {
+    _stop = true;
+    _thread.join();
+    close(_listener);
+  }
+
+  // Waits until the count of the PUBLISH packets reaches the expected.
+  bool  wait(const size_t expected, const int timeoutMs = 10000) {
+    int64_t until = edNow() + static_cast<int64_t>(timeoutMs) * 1000000;
+    while (received.load() < expected) {
+      if (edNow() > until)
+        return false;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+  }
+
+  uint16_t  port;
+  std::vector<int64_t>  arrivals;                       /**< Arrival [ns] of each sequence */
+  std::atomic<size_t> received;                         /**< Number of the PUBLISH packets */
+  std::atomic<size_t> sessions;                         /**< Number of the accepted sessions */
+
+ protected:
+  void  _serve(void) {
+    while (!_stop) {
+      pollfd  pfd = { _listener, POLLIN, 0 };
+      if (poll(&pfd, 1, 10) <= 0)
+        continue;
+      int fd = accept(_listener, nullptr, nullptr);
+      if (fd < 0)
+        continue;
+      sessions++;
+      _session(fd);
+      close(fd);
+    }
+  }
+
+  void  _session(const int fd) {
+    std::vector<uint8_t>  buf;
+    uint8_t chunk[16384];
+
+    while (!_stop) {
+      pollfd  pfd = { fd, POLLIN, 0 };
+      if (poll(&pfd, 1, 10) <= 0)
+        continue;
+      ssize_t n = read(fd, chunk, sizeof(chunk));
+      if (n <= 0)
+        return;
+      const int64_t tm = edNow();
+      buf.insert(buf.end(), chunk, chunk + n);
+
+      size_t  pos = 0;
+      for (;;) {
+        // Fixed header with the remaining length
+        size_t  len = 0, shift = 0, hdr = 1;
+        bool  complete = false;
+        while (pos + hdr < buf.size()) {
+          uint8_t b = buf[pos + hdr++];
+          len |= static_cast<size_t>(b & 0x7f) << shift;
+          shift += 7;
+          if (!(b & 0x80)) {
+            complete = true;
+            break;
+          }
+        }
+        if (!complete || pos + hdr + len > buf.size())
+          break;
+        const uint8_t type = buf[pos] >> 4;
+        const uint8_t*  body = buf.data() + pos + hdr;
+        pos += hdr + len;
+
+        if (type == 1) {
+          const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+          if (write(fd, connack, sizeof(connack)) != sizeof(connack))
+            return;
+        }
+        else if (type == 3) {
+          size_t  tLen = (body[0] << 8) | body[1];
+          const char* payload = reinterpret_cast<const char*>(body) + 2 + tLen;
+          size_t  seq = static_cast<size_t>(-1);
+          if (len > 2 + tLen + 7 && !strncmp(payload, "field1=", 7))
+            seq = strtoul(payload + 7, nullptr, 10);
+          if (seq < arrivals.size())
+            arrivals[seq] = tm;
+          received++;
+        }
+        else if (type == 12) {
+          const uint8_t pingresp[] = { 0xd0, 0x00 };
+          if (write(fd, pingresp, sizeof(pingresp)) != sizeof(pingresp))
+            return;
+        }
+        else if (type == 14)
+          return;
+      }
+      buf.erase(buf.begin(), buf.begin() + pos);
+    }
+  }
+
+  int _listener;
+  std::atomic<bool> _stop;
+  std::thread _thread;
+};
+
+class EdgeMQTTHostClient {
+ public:
+  EdgeMQTTHostClient() : _fd(-1) {}
+  ~EdgeMQTTHostClient() { disconnect(); }
+
+  bool  connected(void) const { return _fd >= 0; }
+
+  // Opens the TCP connection and waits for CONNACK as PubSubClient::connect.
+  // The noDelay disables the Nagle algorithm as WiFiClient::setNoDelay.
+  bool  connect(const uint16_t port, const char* clientId, const bool noDelay = false, const uint16_t keepAlive = 60) {
+    _fd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = noDelay;
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (::connect(_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+      disconnect();
+      return false;
+    }
+
+    size_t  len = 5;
+    const uint8_t variable[] = { 0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, 0x02, static_cast<uint8_t>(keepAlive >> 8), static_cast<uint8_t>(keepAlive) };
+    memcpy(_buffer + len, variable, sizeof(variable));
+    len += sizeof(variable);
+    len = _string(len, clientId, strlen(clientId));
+    if (!_send(0x10, len))
+      return false;
+
+    uint8_t connack[4];
+    size_t  got = 0;
+    while (got < sizeof(connack)) {
+      ssize_t n = read(_fd, connack + got, sizeof(connack) - got);
+      if (n <= 0) {
+        disconnect();
+        return false;
+      }
+      got += n;
+    }
+    return connack[0] == 0x20 && connack[3] == 0;
+  }
+
+  // Writes the PUBLISH packet of QoS 0 as PubSubClient::publish.
+  bool  publish(const char* topic, const char* payload, const size_t pLen) {
+    if (_fd < 0)
+      return false;
+    size_t  len = _string(5, topic, strlen(topic));
+    if (len + pLen > sizeof(_buffer))
+      return false;
+    memcpy(_buffer + len, payload, pLen);
+    return _send(0x30, len + pLen);
+  }
+
+  void  disconnect(void) {
+    if (_fd < 0)
+      return;
+    const uint8_t packet[] = { 0xe0, 0x00 };
+    if (write(_fd, packet, sizeof(packet)) == sizeof(packet))
+      shutdown(_fd, SHUT_WR);
+    close(_fd);
+    _fd = -1;
+  }
+
+ protected:
+  size_t  _string(size_t pos, const char* s, const size_t len) {
+    _buffer[pos++] = static_cast<uint8_t>(len >> 8);
+    _buffer[pos++] = static_cast<uint8_t>(len);
+    memcpy(_buffer + pos, s, len);
+    return pos + len;
+  }
+
+  // Puts the fixed header before the packet built from the 5th byte, and
+  // writes it at once.
+  bool  _send(const uint8_t header, const size_t length) {
+    uint8_t lenBuf[4];
+    size_t  llen = 0;
+    size_t  remain = length - 5;
+    do {
+      uint8_t digit = remain & 0x7f;
+      remain >>= 7;
+      lenBuf[llen++] = remain ? digit | 0x80 : digit;
+    } while (remain);
+    size_t  start = 4 - llen;
+    _buffer[start] = header;
+    memcpy(_buffer + start + 1, lenBuf, llen);
+    size_t  size = length - start;
+    if (write(_fd, _buffer + start, size) != static_cast<ssize_t>(size)) {
+      disconnect();
+      return false;
+    }
+    return true;
+  }
+
+  int _fd;
+  uint8_t _buffer[512];                                 /**< Packet being written */
+};
+
+/**
+ * Latency percentile [us] of the stamped sequences.
+ * @param  sent     Start [ns] of each sequence.
+ * @param  arrivals Arrival [ns] of each sequence.
+ * @param  p        Percentile, 0 to 100.
+ */
+inline double edPercentile(const std::vector<int64_t>& sent, const std::vector<int64_t>& arrivals, const double p) {
+  std::vector<int64_t>  latency;
+  for (size_t i = 0; i < sent.size() && i < arrivals.size(); i++)
+    if (arrivals[i])
+      latency.push_back(arrivals[i] - sent[i]);
+  if (latency.empty())
+    return 0.0;
+  size_t  k = std::min(latency.size() - 1, static_cast<size_t>(p / 100.0 * latency.size()));
+  std::nth_element(latency.begin(), latency.begin() + k, latency.end());
+  return latency[k] / 1000.0;
+}
+
+#endif // !_EDMQTT_STANDIN_H_
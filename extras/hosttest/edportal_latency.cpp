@@ -0,0 +1,236 @@
+/**
+ *	Host simulation of the HTTP latency with EdgePortalService.
+ *	@file	edportal_latency.cpp
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ *
+ * It runs the loop of a sketch on a virtual clock for 10 minutes while the
+ * HTTP requests arrive, and reports the latency from the arrival of each
+ * request to the end of its response, and the number of handleClient calls
+ * per second. The scheduling is the port of EdgeDriverBase::_elapse and
+ * EdgePortalService::_process, and the loops are:
+ * - loop:    the loop of the yamqtt example before the service drivers,
+ *            which calls handleClient every loop after EdgeUnified::process.
+ * - service: EdgePortalService with the busy hold and the idle interval.
+ * The requests are the page loads, where the browser requests the page and
+ * then 4 more resources one after another 15 ms after each response, and
+ * the polls of a single request by a machine client. The other EdgeDrivers
+ * load the loop either lightly, 300 us every 10 ms, or heavily, 2 ms every
+ * turn. The costs below are assumed for ESP8266 at 80 MHz, not measured.
+ * The test fails unless the default service keeps the median latency of
+ * the page within 1 ms of the loop, and the 99th percentile of the polls
+ * within the idle interval and a turn of the other EdgeDrivers.
+ *
+ * usage: edportal_latency
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+// Assumed costs [us]
+const unsigned long LOOP_COST = 100;                    // yield and the WiFi stack per turn
+const unsigned long IDLE_COST = 20;                     // handleClient without a request
+const unsigned long SERVE_COST = 4000;                  // handleClient serving a request
+const unsigned long PAGE_PERIOD = 3000000;              // A page load every 3 s
+const unsigned long PAGE_RESOURCES = 5;
+const unsigned long PAGE_THINK = 15000;                 // Next request after the response
+const unsigned long POLL_PERIOD = 2000000;              // A poll every 2 s
+const unsigned long DURATION = 600000000;
+
+// Same as EdgeServices.h
+const unsigned long BUSYTHRESHOLD = 1000;               // ED_SERVICE_PORTAL_BUSYTHRESHOLD
+
+unsigned long clock_us;
+unsigned long millis(void) { return clock_us / 1000; }
+unsigned long micros(void) { return clock_us; }
+
+// Deterministic pseudo random numbers
+uint32_t  seed;
+uint32_t  rnd(const uint32_t range) {
+  seed = seed * 1664525UL + 1013904223UL;
+  return (seed >> 8) % range;
+}
+
+/**
+ * Stand-in of the WebServer that serves one request per handleClient.
+ */
+class Portal {
+ public:
+  Portal() { reset(); }
+
+  void  reset(void) {
+    _page.clear();
+    _poll.clear();
+    _pageArrival = rnd(PAGE_PERIOD);
+    _pollArrival = rnd(POLL_PERIOD);
+    _resource = 0;
+    calls = 0;
+  }
+
+  void  handleClient(void) {
+    calls++;
+    bool  page = _resource < PAGE_RESOURCES && _pageArrival <= clock_us;
+    bool  poll = _pollArrival <= clock_us;
+    if (page && (!poll || _pageArrival <= _pollArrival)) {
+      clock_us += SERVE_COST;
+      _page.push_back(clock_us - _pageArrival);
+      if (++_resource < PAGE_RESOURCES)
+        _pageArrival = clock_us + PAGE_THINK;
+      else {
+        _pageArrival = (clock_us / PAGE_PERIOD + 1) * PAGE_PERIOD + rnd(PAGE_PERIOD / 2);
+        _resource = 0;
+      }
+    }
+    else if (poll) {
+      clock_us += SERVE_COST;
+      _poll.push_back(clock_us - _pollArrival);
+      _pollArrival += POLL_PERIOD;
+    }
+    else
+      clock_us += IDLE_COST;
+  }
+
+  static unsigned long  percentile(std::vector<unsigned long>& latency, const double p) {
+    if (latency.empty())
+      return 0;
+    size_t  k = std::min(latency.size() - 1, static_cast<size_t>(p / 100.0 * latency.size()));
+    std::nth_element(latency.begin(), latency.begin() + k, latency.end());
+    return latency[k];
+  }
+
+  std::vector<unsigned long>  _page;
+  std::vector<unsigned long>  _poll;
+  unsigned long calls;
+
+ private:
+  unsigned long _pageArrival;
+  unsigned long _pollArrival;
+  unsigned long _resource;
+};
+
+Portal  portal;
+
+/**
+ * Port of the interval of EdgeDriverBase without the slack.
+ */
+class Driver {
+ public:
+  explicit Driver(const unsigned long interval = 0, const unsigned long cost = 0) : _interval(interval), _tm(millis()), _cost(cost) {}
+  virtual ~Driver() {}
+
+  void  process(void) {
+    if (_elapse())
+      _process();
+  }
+  void  setEdgeInterval(const unsigned long interval) { _interval = interval; _tm = millis(); }
+
+ protected:
+  bool  _elapse(void) {
+    if (millis() - _tm > _interval) {
+      _tm = millis();
+      return true;
+    }
+    return false;
+  }
+  virtual void  _process(void) { clock_us += _cost; }
+
+  unsigned long _interval;
+  unsigned long _tm;
+  unsigned long _cost;
+};
+
+/**
+ * Port of EdgePortalService.
+ */
+class PortalService : public Driver {
+ public:
+  PortalService(const unsigned long idleInterval, const unsigned long busyHold) : _idleInterval(idleInterval), _busyHold(busyHold), _busy(millis()) {}
+
+ protected:
+  void  _process(void) override {
+    unsigned long tm = micros();
+    portal.handleClient();
+    if (micros() - tm >= BUSYTHRESHOLD) {
+      _busy = millis();
+      if (_interval)
+        setEdgeInterval(0);
+    }
+    else if (!_interval && millis() - _busy > _busyHold)
+      setEdgeInterval(_idleInterval);
+  }
+
+  unsigned long _idleInterval;
+  unsigned long _busyHold;
+  unsigned long _busy;
+};
+
+struct Load {
+  const char* name;
+  unsigned long interval;
+  unsigned long cost;
+};
+
+struct Result {
+  unsigned long pageP50;
+  unsigned long pollP99;
+};
+
+Result  run(const Load& load, const char* name, const bool service, const unsigned long idleInterval, const unsigned long busyHold) {
+  clock_us = 0;
+  seed = 12345;
+  portal.reset();
+  Driver  driver(load.interval, load.cost);
+  PortalService portalService(idleInterval, busyHold);
+
+  // The portal service precedes the other EdgeDrivers by the priority.
+  while (clock_us < DURATION) {
+    if (service)
+      portalService.process();
+    driver.process();
+    if (!service)
+      portal.handleClient();
+    clock_us += LOOP_COST;
+  }
+
+  Result  result = { Portal::percentile(portal._page, 50), Portal::percentile(portal._poll, 99) };
+  printf("%-6s %-26s %9.1f %9.1f %9.1f %9.1f %12.0f\n", load.name, name,
+    result.pageP50 / 1000.0, Portal::percentile(portal._page, 99) / 1000.0,
+    Portal::percentile(portal._poll, 50) / 1000.0, result.pollP99 / 1000.0,
+    portal.calls / (DURATION / 1e6));
+  return result;
+}
+
+} // namespace
+
+int main(void) {
+  const Load  loads[] = {
+    { "light", 10, 300 },
+    { "heavy", 0, 2000 }
+  };
+
+  const unsigned long idleInterval = 10;                 // ED_SERVICE_PORTAL_IDLEINTERVAL
+  const unsigned long busyHold = 1000;                  // ED_SERVICE_PORTAL_BUSYHOLD
+  bool  rc = true;
+
+  printf("%-6s %-26s %9s %9s %9s %9s %12s\n", "load", "loop", "page p50", "page p99", "poll p50", "poll p99", "handleClient");
+  printf("%-6s %-26s %9s %9s %9s %9s %12s\n", "", "", "[ms]", "[ms]", "[ms]", "[ms]", "[/s]");
+  for (const Load& load : loads) {
+    Result  loop = run(load, "loop", false, 0, 0);
+    Result  service = run(load, "service idle 10 hold 1000", true, idleInterval, busyHold);
+    run(load, "service idle 10 hold 0", true, 10, 0);
+    run(load, "service idle 50 hold 1000", true, 50, 1000);
+    run(load, "service idle 50 hold 0", true, 50, 0);
+    if (service.pageP50 > loop.pageP50 + 1000 || service.pollP99 > loop.pollP99 + idleInterval * 1000 + load.cost) {
+      printf("FAIL: the service delays the requests under the %s load\n", load.name);
+      rc = false;
+    }
+  }
+  return rc ? 0 : 1;
+}
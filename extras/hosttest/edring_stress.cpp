@@ -0,0 +1,164 @@
+/**
+ *	Host stress test of EdgeRing.
+ *	@file	edring_stress.cpp
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ *
+ * A thread stands in for the interrupt service routine of EdgeInput and
+ * pushes the edges at the given rates, while the main thread drains them
+ * at the interval of the process as the loop does. Every edge must be
+ * either popped in order without tearing, or counted as the overflow.
+ * It also checks the full ring and the wraparound of the counters without
+ * the threads.
+ *
+ * usage: edring_stress [milliseconds per rate]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include "EdgeRing.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Same layout as the edge of EdgeInput, the level is derived from the
+// sequence to detect the torn elements.
+struct Edge {
+  uint32_t  tm;
+  bool  level;
+};
+
+const size_t  RING_SIZE = 32;                           // ED_INPUT_RING_SIZE
+const long    DRAIN_INTERVAL = 10;                      // ED_INPUT_INTERVAL [ms]
+
+// Exposes the counters to start them near the wraparound.
+template<typename T, size_t N>
+class EdgeRingAt : public EdgeRing<T, N> {
+ public:
+  explicit EdgeRingAt(const uint32_t count) {
+    this->_head = count;
+    this->_tail = count;
+  }
+};
+
+int failures = 0;
+
+void  expect(const bool condition, const char* what) {
+  if (!condition) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+void  testSingle(const uint32_t start) {
+  EdgeRingAt<Edge, RING_SIZE> ring(start);
+  Edge  edge;
+
+  expect(!ring.pop(edge), "pop from the empty ring");
+  for (uint32_t round = 0; round < 3; round++) {
+    for (uint32_t n = 0; n < RING_SIZE; n++)
+      expect(ring.push({ n, static_cast<bool>(n & 1) }), "push into the ring with room");
+    expect(!ring.push({ 0, false }), "push into the full ring");
+    for (uint32_t n = 0; n < RING_SIZE; n++)
+      expect(ring.pop(edge) && edge.tm == n, "pop in the pushed order");
+    expect(!ring.pop(edge), "pop from the drained ring");
+  }
+}
+
+struct Result {
+  uint32_t  generated;
+  uint32_t  popped;
+  uint32_t  overflows;
+  uint32_t  maxBacklog;
+};
+
+/**
+ * Generates the edges at the rate [edges/s] for the duration. The rate 0
+ * generates them as fast as the producer can.
+ */
+Result  stress(const uint32_t rate, const long duration) {
+  static EdgeRing<Edge, RING_SIZE>  ring;
+  std::atomic<uint32_t> overflows(0);
+  std::atomic<uint32_t> generated(0);
+  std::atomic<bool> running(true);
+  Result  result = { 0, 0, 0, 0 };
+
+  std::thread isr([&]() {
+    const Clock::duration period = rate ? std::chrono::nanoseconds(1000000000UL / rate) : Clock::duration::zero();
+    Clock::time_point due = Clock::now();
+    uint32_t  seq = 0;
+    while (running) {
+      if (rate) {
+        while (Clock::now() < due) {}
+        due += period;
+      }
+      if (!ring.push({ seq, static_cast<bool>(seq & 1) }))
+        overflows++;
+      generated = ++seq;
+    }
+  });
+
+  // The process drains the ring at its interval.
+  Clock::time_point end = Clock::now() + std::chrono::milliseconds(duration);
+  uint32_t  expected = 0;
+  bool  ordered = true;
+  bool  torn = false;
+  auto  drain = [&]() {
+    Edge  edge;
+    uint32_t  backlog = 0;
+    while (ring.pop(edge)) {
+      if (edge.tm < expected)
+        ordered = false;
+      if (edge.level != static_cast<bool>(edge.tm & 1))
+        torn = true;
+      expected = edge.tm + 1;
+      result.popped++;
+      backlog++;
+    }
+    if (backlog > result.maxBacklog)
+      result.maxBacklog = backlog;
+  };
+  while (Clock::now() < end) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_INTERVAL));
+    drain();
+  }
+  running = false;
+  isr.join();
+  drain();
+
+  result.generated = generated;
+  result.overflows = overflows;
+  expect(ordered, "edges popped out of order");
+  expect(!torn, "torn edge popped");
+  expect(result.popped + result.overflows == result.generated, "edges neither popped nor counted as the overflow");
+  expect(result.maxBacklog <= RING_SIZE, "backlog beyond the ring size");
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  long  duration = argc > 1 ? strtol(argv[1], nullptr, 10) : 500;
+
+  testSingle(0);
+  testSingle(UINT32_MAX - RING_SIZE / 2);
+
+  printf("ring %zu edges, drained every %ld ms, %ld ms per rate\n", RING_SIZE, DRAIN_INTERVAL, duration);
+  printf("%12s %12s %12s %12s %12s\n", "edges/s", "generated", "popped", "overflows", "max backlog");
+  const uint32_t  rates[] = { 1000, 3000, 10000, 100000, 1000000, 0 };
+  for (uint32_t rate : rates) {
+    Result  result = stress(rate, duration);
+    char  label[16];
+    snprintf(label, sizeof(label), rate ? "%u" : "unlimited", rate);
+    printf("%12s %12u %12u %12u %12u\n", label, result.generated, result.popped, result.overflows, result.maxBacklog);
+    // Up to the ring size per interval, the ISR must never lose an edge.
+    if (rate && rate * DRAIN_INTERVAL / 1000 < RING_SIZE / 2)
+      expect(!result.overflows, "edges lost below the capacity of the ring");
+  }
+  return failures ? 1 : 0;
+}
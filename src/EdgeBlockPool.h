@@ -0,0 +1,100 @@
+/**
+ *	Declaration of EdgeBlockPool class.
+ *	@file	EdgeBlockPool.h
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ */
+
+#ifndef _EDGEBLOCKPOOL_H_
+#define _EDGEBLOCKPOOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+/**
+ * EdgeBlockPool: Fixed block pool for the instances of T. It reserves the
+ * blocks in one piece at the first allocation and recycles them, so that
+ * repeated creation and destruction do not fragment the heap. The instances
+ * beyond the blocks are allocated from the heap individually.
+ * It depends only on the standard library so that extras/hosttest can
+ * exercise it without the Arduino core.
+ * @param  blocks  Number of the blocks. The maximum value is 32.
+ */
+template<typename T>
+class EdgeBlockPool {
+ public:
+  explicit EdgeBlockPool(const uint8_t blocks) : _count(blocks < 32 ? blocks : 32) {}
+  ~EdgeBlockPool() { ::operator delete(_blocks); }
+
+  /**
+   * Constructs an instance in a free block.
+   * @return A pointer to the constructed instance. nullptr if no block is free.
+   */
+  T*  acquire(void) {
+    if (!_blocks && _count)
+      _blocks = static_cast<EdgeBlockT*>(::operator new(sizeof(EdgeBlockT) * _count, std::nothrow));
+
+    if (_blocks) {
+      for (uint8_t n = 0; n < _count; n++) {
+        if (!(_inUse & (1UL << n))) {
+          _inUse |= 1UL << n;
+          return new(&_blocks[n]) T;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Creates an instance in a free block, or from the heap if the pool has
+   * no free block.
+   */
+  T*  create(void) {
+    T*  obj = acquire();
+    return obj ? obj : new T;
+  }
+
+  /**
+   * Destroys the instance created by the pool and returns its block.
+   * @param  obj  A pointer to the instance.
+   */
+  void  destroy(T* obj) {
+    if (owns(obj)) {
+      obj->~T();
+      _inUse &= ~(1UL << (reinterpret_cast<EdgeBlockT*>(obj) - _blocks));
+    }
+    else
+      delete obj;
+  }
+
+  /**
+   * Returns whether the instance occupies a block of the pool.
+   */
+  bool  owns(const T* obj) const {
+    const EdgeBlockT* block = reinterpret_cast<const EdgeBlockT*>(obj);
+    return _blocks && block >= _blocks && block < _blocks + _count;
+  }
+
+  /**
+   * Returns the number of the blocks in use.
+   */
+  uint8_t inUse(void) const {
+    uint8_t count = 0;
+    for (uint32_t bits = _inUse; bits; bits &= bits - 1)
+      count++;
+    return count;
+  }
+
+ protected:
+  typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type  EdgeBlockT;
+
+  EdgeBlockT* _blocks = nullptr;                        /**< Reserved blocks */
+  uint8_t   _count;                                     /**< Number of the blocks */
+  uint32_t  _inUse = 0;                                 /**< Bitmap of the blocks in use */
+};
+
+#endif // !_EDGEBLOCKPOOL_H_
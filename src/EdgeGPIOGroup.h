@@ -0,0 +1,164 @@
+/**
+ *	Declaration of EdgeGPIOGroup class.
+ *	@file	EdgeGPIOGroup.h
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ */
+
+#ifndef _EDGEGPIOGROUP_H_
+#define _EDGEGPIOGROUP_H_
+
+#include "EdgeUnified.h"
+#if defined(ARDUINO_ARCH_ESP32)
+#include <soc/gpio_reg.h>
+#include <soc/soc_caps.h>
+#endif
+
+// Maximum number of the pins in a group.
+#ifndef ED_GPIOGROUP_PINS
+#define ED_GPIOGROUP_PINS                     24
+#endif // !ED_GPIOGROUP_PINS
+
+// Default interval [ms] of a step of the patterns.
+#ifndef ED_GPIOGROUP_INTERVAL
+#define ED_GPIOGROUP_INTERVAL                 100
+#endif // !ED_GPIOGROUP_INTERVAL
+
+// Number of the output ports written by one register access each.
+#if defined(ARDUINO_ARCH_ESP32) && SOC_GPIO_PIN_COUNT > 32
+#define ED_GPIOGROUP_PORTS                    2
+#else
+#define ED_GPIOGROUP_PORTS                    1
+#endif
+
+/**
+ * EdgeData of EdgeGPIOGroup. It consists of the plain values only, so the
+ * whole group is saved and restored as the EdgeData of one EdgeDriver.
+ */
+typedef struct {
+  uint8_t count = 0;                                    /**< Number of the pins in the group */
+  uint8_t steps = 32;                                   /**< Length of the patterns, up to 32 */
+  uint8_t pin[ED_GPIOGROUP_PINS];                       /**< GPIO pins of the group */
+  uint32_t  pattern[ED_GPIOGROUP_PINS];                 /**< Output level of each pin, bit n is the level at step n */
+  uint32_t  activeLow = 0;                              /**< Bit n inverts the output of the nth pin */
+  unsigned long interval = ED_GPIOGROUP_INTERVAL;       /**< Interval of a step */
+} EdgeGPIOGroup_t;
+
+/**
+ * EdgeGPIOGroup: GPIO EdgeDriver that drives a group of the output pins by
+ * the patterns. In each turn of the process, it advances one step of the
+ * patterns, composes the output levels of all pins into the set and clear
+ * masks per port, and applies them with one write of the W1TS and the W1TC
+ * register each. All the pins in the group change at the same time without
+ * the skew of the individual digitalWrite calls. On the architecture without
+ * the known registers, it falls back to digitalWrite.
+ */
+class EdgeGPIOGroup : public EdgeDriver<EdgeGPIOGroup_t> {
+ public:
+  EdgeGPIOGroup() {
+    static_assert(ED_GPIOGROUP_PINS <= 32, "EdgeGPIOGroup allows up to 32 pins");
+    _cbStart = [this]() { _start(); };
+    _cbProcess = [this]() { _process(); };
+    _cbEnd = [this]() { write(0); };
+  }
+  ~EdgeGPIOGroup() {
+    // Turns the started group off while the members are alive, which
+    // ~EdgeDriverBase would outlive.
+    if (!_started)
+      _cbEnd = nullptr;
+    _dispose();
+  }
+
+  /**
+   * Adds a pin to the group.
+   * @param  pin      GPIO pin.
+   * @param  pattern  Output levels of the pin at each step.
+   * @param  activeLow  The pin is active with LOW level.
+   * @return The index of the pin in the group. If it is negative, the group
+   * is full.
+   */
+  int add(const uint8_t pin, const uint32_t pattern, const bool activeLow = false) {
+    if (data.count >= ED_GPIOGROUP_PINS)
+      return -1;
+    data.pin[data.count] = pin;
+    data.pattern[data.count] = pattern;
+    if (activeLow)
+      data.activeLow |= 1UL << data.count;
+    else
+      data.activeLow &= ~(1UL << data.count);
+    return data.count++;
+  }
+
+  uint8_t step(void) const { return _step; }
+
+  /**
+   * Outputs the levels to all pins in the group at once.
+   * @param  levels Bit n is the active state of the nth pin.
+   */
+  void  write(const uint32_t levels) {
+    uint32_t  set[ED_GPIOGROUP_PORTS] = { 0 };
+    uint32_t  clr[ED_GPIOGROUP_PORTS] = { 0 };
+
+    for (uint8_t n = 0; n < data.count; n++) {
+      const uint8_t pin = data.pin[n];
+      const bool  level = ((levels ^ data.activeLow) >> n) & 1;
+#if defined(ARDUINO_ARCH_ESP8266)
+      if (pin == 16) {
+        // GPIO16 is in the RTC block, apart from GPOS and GPOC.
+        GP16O = level;
+        continue;
+      }
+      if (pin < 16)
+        (level ? set : clr)[0] |= 1UL << pin;
+#elif defined(ARDUINO_ARCH_ESP32)
+      if (pin < SOC_GPIO_PIN_COUNT)
+        (level ? set : clr)[pin >> 5] |= 1UL << (pin & 31);
+#else
+      digitalWrite(pin, level);
+#endif
+    }
+
+#if defined(ARDUINO_ARCH_ESP8266)
+    GPOS = set[0];
+    GPOC = clr[0];
+#elif defined(ARDUINO_ARCH_ESP32)
+    REG_WRITE(GPIO_OUT_W1TS_REG, set[0]);
+    REG_WRITE(GPIO_OUT_W1TC_REG, clr[0]);
+#if ED_GPIOGROUP_PORTS > 1
+    REG_WRITE(GPIO_OUT1_W1TS_REG, set[1]);
+    REG_WRITE(GPIO_OUT1_W1TC_REG, clr[1]);
+#endif
+#endif
+    _levels = levels;
+  }
+
+  uint32_t  levels(void) const { return _levels; }
+
+ protected:
+  void  _start(void) {
+    for (uint8_t n = 0; n < data.count; n++)
+      pinMode(data.pin[n], OUTPUT);
+    if (!data.steps || data.steps > 32)
+      data.steps = 32;
+    _step = data.steps - 1;
+    write(0);
+    setEdgeInterval(data.interval);
+  }
+
+  void  _process(void) {
+    if (++_step >= data.steps)
+      _step = 0;
+
+    uint32_t  levels = 0;
+    for (uint8_t n = 0; n < data.count; n++)
+      levels |= ((data.pattern[n] >> _step) & 1) << n;
+    write(levels);
+  }
+
+  uint8_t _step = 0;                                    /**< Current step of the patterns */
+  uint32_t  _levels = 0;                                /**< Active states of the pins being output */
+};
+
+#endif // !_EDGEGPIOGROUP_H_
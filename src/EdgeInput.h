@@ -0,0 +1,165 @@
+/**
+ *	Declaration of EdgeInput class.
+ *	@file	EdgeInput.h
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ */
+
+#ifndef _EDGEINPUT_H_
+#define _EDGEINPUT_H_
+
+#include "EdgeUnified.h"
+#include "EdgeRing.h"
+
+// Number of the edges that the ring buffer holds between the drains. It
+// must be a power of 2.
+#ifndef ED_INPUT_RING_SIZE
+#define ED_INPUT_RING_SIZE                    32
+#endif // !ED_INPUT_RING_SIZE
+
+// Default interval [ms] at which the process drains the captured edges.
+#ifndef ED_INPUT_INTERVAL
+#define ED_INPUT_INTERVAL                     10
+#endif // !ED_INPUT_INTERVAL
+
+// Default period [ms] for which the level must be stable to be accepted,
+// and the default duration [ms] of the press regarded as the long press.
+#ifndef ED_INPUT_DEBOUNCE
+#define ED_INPUT_DEBOUNCE                     20
+#endif // !ED_INPUT_DEBOUNCE
+#ifndef ED_INPUT_LONGPRESS
+#define ED_INPUT_LONGPRESS                    1000
+#endif // !ED_INPUT_LONGPRESS
+
+/**
+ * EdgeData of EdgeInput.
+ */
+typedef struct {
+  uint8_t pin = 0;                                      /**< GPIO pin of the input */
+  bool  activeLow = true;                               /**< Pressed at LOW level */
+  bool  pullup = true;                                  /**< Enables the internal pull-up */
+  unsigned long debounce = ED_INPUT_DEBOUNCE;           /**< Stable period to accept the level */
+  unsigned long longPress = ED_INPUT_LONGPRESS;         /**< Duration of the long press, 0 disables */
+  unsigned long interval = ED_INPUT_INTERVAL;           /**< Interval of draining the edges */
+} EdgeInput_t;
+
+/**
+ * EdgeInput: Digital input EdgeDriver. The interrupt service routine
+ * captures every edge of the pin with the timestamp into EdgeRing, so the
+ * short pulses are not missed regardless of the loop load. The process
+ * drains the captured edges at its interval, debounces them in bulk, and
+ * notifies the press, the release and the long press to the event handler.
+ */
+class EdgeInput : public EdgeDriver<EdgeInput_t> {
+ public:
+  typedef enum {
+    ED_INPUT_EVENT_PRESS,
+    ED_INPUT_EVENT_RELEASE,
+    ED_INPUT_EVENT_LONGPRESS
+  } EdgeInputEvent_t;
+
+  typedef std::function<void(EdgeInput&, const EdgeInputEvent_t)> EdgeInputHandlerT;
+
+  explicit EdgeInput(const uint8_t pin = 0) {
+    data.pin = pin;
+    _cbStart = [this]() { _start(); };
+    _cbProcess = [this]() { _process(); };
+    _cbEnd = [this]() { detachInterrupt(data.pin); };
+  }
+  ~EdgeInput() {
+    // Detaches the interrupt service routine that writes into _edges while
+    // the members are alive, which ~EdgeDriverBase would outlive.
+    if (!_started)
+      _cbEnd = nullptr;
+    _dispose();
+  }
+
+  bool  isPressed(void) const { return _pressed; }
+  void  onEvent(EdgeInputHandlerT handler) { _onEvent = handler; }
+  unsigned long overflows(void) const { return _overflows; }
+  unsigned long pressed(void) const { return _pressed ? (micros() - _pressedTm) / 1000 : 0; }
+
+ protected:
+  // An edge captured by the interrupt service routine
+  typedef struct {
+    uint32_t  tm;                                       /**< Time of the edge [us] */
+    bool  level;                                        /**< Level after the edge */
+  } EdgeInputEdge_t;
+
+  static void IRAM_ATTR _capture(void* arg) {
+    EdgeInput*  input = static_cast<EdgeInput*>(arg);
+    if (!input->_edges.push({ static_cast<uint32_t>(micros()), static_cast<bool>(digitalRead(input->data.pin)) }))
+      input->_overflows++;
+  }
+
+  void  _start(void) {
+    pinMode(data.pin, data.pullup ? INPUT_PULLUP : INPUT);
+    EdgeInputEdge_t edge;
+    while (_edges.pop(edge)) {}
+    _level = digitalRead(data.pin);
+    _levelTm = micros();
+    _pressed = _level != data.activeLow;
+    _pressedTm = _levelTm;
+    _longPressed = _pressed;
+    attachInterruptArg(data.pin, _capture, this, CHANGE);
+    setEdgeInterval(data.interval);
+  }
+
+  /**
+   * Debounces the drained edges. A level that continued for the debounce
+   * period before the next edge is accepted at the time it started.
+   */
+  void  _process(void) {
+    EdgeInputEdge_t edge;
+    const uint32_t  debounce = data.debounce * 1000;
+
+    while (_edges.pop(edge)) {
+      if (edge.tm - _levelTm >= debounce)
+        _accept();
+      _level = edge.level;
+      _levelTm = edge.tm;
+    }
+    uint32_t  now = micros();
+    if (_overflows != _overflowsSeen) {
+      // The lost edges leave the last level unreliable, so it is sampled.
+      _overflowsSeen = _overflows;
+      _level = digitalRead(data.pin);
+      _levelTm = now;
+    }
+    if (now - _levelTm >= debounce)
+      _accept();
+
+    if (_pressed && !_longPressed && data.longPress && now - _pressedTm >= data.longPress * 1000) {
+      _longPressed = true;
+      if (_onEvent)
+        _onEvent(*this, ED_INPUT_EVENT_LONGPRESS);
+    }
+  }
+
+  void  _accept(void) {
+    bool  pressed = _level != data.activeLow;
+    if (pressed == _pressed)
+      return;
+    _pressed = pressed;
+    if (pressed) {
+      _pressedTm = _levelTm;
+      _longPressed = false;
+    }
+    if (_onEvent)
+      _onEvent(*this, pressed ? ED_INPUT_EVENT_PRESS : ED_INPUT_EVENT_RELEASE);
+  }
+
+  EdgeRing<EdgeInputEdge_t, ED_INPUT_RING_SIZE> _edges; /**< Edges captured by the interrupt */
+  volatile unsigned long  _overflows = 0;               /**< Number of the edges lost by the full ring */
+  unsigned long _overflowsSeen = 0;                     /**< Number of the lost edges already resampled */
+  EdgeInputHandlerT _onEvent;                           /**< Event handler */
+  bool  _level = false;                                 /**< Level of the last edge */
+  uint32_t  _levelTm = 0;                               /**< Time of the last edge [us] */
+  bool  _pressed = false;                               /**< Debounced state */
+  uint32_t  _pressedTm = 0;                             /**< Time when the press was accepted [us] */
+  bool  _longPressed = false;                           /**< The long press of the current press was notified */
+};
+
+#endif // !_EDGEINPUT_H_
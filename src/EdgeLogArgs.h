@@ -0,0 +1,304 @@
+/**
+ *	Declaration of EdgeLogArgs class.
+ *	@file	EdgeLogArgs.h
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ */
+
+#ifndef _EDGELOGARGS_H_
+#define _EDGELOGARGS_H_
+
+#include <cctype>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// The Arduino core gives PGM_P and pgm_read_byte, so this header should be
+// included after Arduino.h to read the format string from PROGMEM.
+#ifndef PGM_P
+#define PGM_P const char*
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t*>(addr))
+#endif
+
+/**
+ * EdgeLogArgs: Raw arguments of a deferred debug record. The pack function
+ * stores the arguments of a printf format string without formatting them,
+ * and the format function formats them later with the same format string.
+ * Each conversion specification takes the argument in the size that it
+ * implies, 4 or 8 bytes, and the string arguments are copied with the
+ * terminator. The width and the precision given by `*` are stored as the
+ * int before the argument.
+ * It has no constructor, so the static storage zero-initializes it. It
+ * depends only on the standard library so that extras/hosttest can
+ * exercise it without the Arduino core.
+ * @param  N  Size of the stored arguments, up to 255.
+ */
+template<size_t N>
+class EdgeLogArgs {
+ public:
+  void  clear(void) { _len = 0; _truncated = false; }
+  const uint8_t*  data(void) const { return _data; }
+  size_t  length(void) const { return _len; }
+  bool  truncated(void) const { return _truncated; }
+
+  /**
+   * Stores the arguments of the format string.
+   * @param  fmt  Format string in PROGMEM.
+   * @param  args Arguments of the format string.
+   */
+  void  pack(PGM_P fmt, va_list args) {
+    char  c;
+
+    while ((c = static_cast<char>(pgm_read_byte(fmt++)))) {
+      if (c != '%')
+        continue;
+
+      // Scan a conversion specification as format does
+      size_t  n = 1;
+      uint8_t longs = 0;
+      uint8_t stars = 0;
+      bool  sized = false;
+      while ((c = static_cast<char>(pgm_read_byte(fmt))) && n < 11) {
+        fmt++;
+        n++;
+        if (c == 'l')
+          longs++;
+        else if (c == 'z' || c == 't')
+          sized = true;
+        else if (c == '*') {
+          int32_t v = va_arg(args, int);
+          store(&v, sizeof(v));
+          if (++stars > 2)
+            return;
+        }
+        else if (c == '%' || (isalpha(c) && !strchr("hjzt", c)))
+          break;
+      }
+
+      switch (c) {
+      case 'd':
+      case 'i':
+      case 'c':
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+        if (longs > 1) {
+          uint64_t  v = va_arg(args, unsigned long long);
+          store(&v, sizeof(v));
+        }
+        else {
+          uint32_t  v = longs ? va_arg(args, unsigned long) : sized ? va_arg(args, size_t) : va_arg(args, unsigned int);
+          store(&v, sizeof(v));
+        }
+        break;
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'g':
+      case 'G': {
+        double  v = va_arg(args, double);
+        store(&v, sizeof(v));
+        break;
+      }
+      case 'p': {
+        uint32_t  v = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(va_arg(args, void*)));
+        store(&v, sizeof(v));
+        break;
+      }
+      case 's':
+        put(va_arg(args, const char*));
+        break;
+      default:
+        // The arguments after an unknown specification cannot be located.
+        if (c != '%')
+          return;
+      }
+    }
+  }
+
+  /**
+   * Formats the stored arguments with the format string that stored them.
+   * An unknown specification or a truncated argument is left as it is.
+   * @param  out  Output buffer.
+   * @param  size Size of the output buffer, not zero.
+   * @param  fmt  Format string in PROGMEM.
+   * @return Length of the formatted string.
+   */
+  size_t  format(char* out, const size_t size, PGM_P fmt) const {
+    size_t  pos = 0;
+    size_t  len = 0;
+    char  c;
+
+    while ((c = static_cast<char>(pgm_read_byte(fmt++))) && len < size - 1) {
+      if (c != '%') {
+        out[len++] = c;
+        continue;
+      }
+
+      // Extract a conversion specification with the width and the
+      // precision given by the arguments
+      char  spec[12] = { '%' };
+      size_t  n = 1;
+      uint8_t longs = 0;
+      bool  sized = false;
+      int32_t stars[2];
+      uint8_t nStars = 0;
+      bool  taken = true;
+      while ((c = static_cast<char>(pgm_read_byte(fmt))) && n < sizeof(spec) - 1) {
+        fmt++;
+        spec[n++] = c;
+        if (c == 'l')
+          longs++;
+        else if (c == 'z' || c == 't')
+          sized = true;
+        else if (c == '*') {
+          if (nStars < 2)
+            taken &= _take(pos, &stars[nStars++], sizeof(stars[0]));
+          else
+            taken = false;
+        }
+        else if (c == '%' || (isalpha(c) && !strchr("hjzt", c)))
+          break;
+      }
+      spec[n] = '\0';
+
+      char* buf = out + len;
+      size_t  room = size - len;
+      int rc = -1;
+      switch (taken ? c : '\0') {
+      case '%':
+        rc = snprintf(buf, room, "%%");
+        break;
+      case 'd':
+      case 'i':
+      case 'c':
+        if (longs > 1) {
+          int64_t v;
+          if (_take(pos, &v, sizeof(v)))
+            rc = _print(buf, room, spec, stars, nStars, v);
+        }
+        else {
+          // The 4 bytes are widened back to the type that the
+          // specification reads.
+          int32_t v;
+          if (_take(pos, &v, sizeof(v)))
+            rc = longs ? _print(buf, room, spec, stars, nStars, static_cast<long>(v)) : sized ? _print(buf, room, spec, stars, nStars, static_cast<ptrdiff_t>(v)) : _print(buf, room, spec, stars, nStars, v);
+        }
+        break;
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+        if (longs > 1) {
+          uint64_t  v;
+          if (_take(pos, &v, sizeof(v)))
+            rc = _print(buf, room, spec, stars, nStars, v);
+        }
+        else {
+          uint32_t  v;
+          if (_take(pos, &v, sizeof(v)))
+            rc = longs ? _print(buf, room, spec, stars, nStars, static_cast<unsigned long>(v)) : sized ? _print(buf, room, spec, stars, nStars, static_cast<size_t>(v)) : _print(buf, room, spec, stars, nStars, v);
+        }
+        break;
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'g':
+      case 'G': {
+        double  v;
+        if (_take(pos, &v, sizeof(v)))
+          rc = _print(buf, room, spec, stars, nStars, v);
+        break;
+      }
+      case 'p': {
+        uint32_t  v;
+        if (_take(pos, &v, sizeof(v)))
+          rc = _print(buf, room, spec, stars, nStars, reinterpret_cast<void*>(static_cast<uintptr_t>(v)));
+        break;
+      }
+      case 's':
+        if (pos < _len) {
+          const char* v = reinterpret_cast<const char*>(_data) + pos;
+          pos += strnlen(v, _len - pos) + 1;
+          rc = _print(buf, room, spec, stars, nStars, v);
+        }
+        break;
+      }
+      if (rc < 0)
+        rc = snprintf(buf, room, "%s", spec);
+      len += rc < static_cast<int>(room) ? static_cast<size_t>(rc) : room - 1;
+    }
+    out[len] = '\0';
+    return len;
+  }
+
+  /**
+   * Copies the string argument. The string that does not fit is cut off,
+   * and the arguments after it are truncated.
+   * @param  value  String.
+   */
+  void  put(const char* value) {
+    if (_truncated)
+      return;
+    if (!value)
+      value = "(null)";
+
+    size_t  room = N - _len;
+    size_t  len = strnlen(value, room);
+    if (len >= room) {
+      _truncated = true;
+      if (!room)
+        return;
+      len = room - 1;
+    }
+    memcpy(_data + _len, value, len);
+    _data[_len + len] = '\0';
+    _len += len + 1;
+  }
+
+  /**
+   * Copies the raw argument. The argument that does not fit and the
+   * arguments after it are truncated.
+   * @param  value  Argument.
+   * @param  size   Size of the argument.
+   */
+  void  store(const void* value, const size_t size) {
+    if (_truncated || _len + size > N) {
+      _truncated = true;
+      return;
+    }
+    memcpy(_data + _len, value, size);
+    _len += size;
+  }
+
+ protected:
+  bool  _take(size_t& pos, void* value, const size_t size) const {
+    if (pos + size > _len)
+      return false;
+    memcpy(value, _data + pos, size);
+    pos += size;
+    return true;
+  }
+
+  template<typename T>
+  static int  _print(char* buf, const size_t size, const char* spec, const int32_t* stars, const uint8_t nStars, const T value) {
+    if (nStars == 2)
+      return snprintf(buf, size, spec, static_cast<int>(stars[0]), static_cast<int>(stars[1]), value);
+    if (nStars == 1)
+      return snprintf(buf, size, spec, static_cast<int>(stars[0]), value);
+    return snprintf(buf, size, spec, value);
+  }
+
+  uint8_t _len;                                         /**< Size of the stored arguments */
+  bool  _truncated;                                     /**< Some arguments were truncated */
+  uint8_t _data[N];                                     /**< Raw arguments */
+};
+
+#endif // !_EDGELOGARGS_H_
@@ -0,0 +1,584 @@
+/**
+ *	Declaration of EdgeMQTTDriver class.
+ *	@file	EdgeMQTT.h
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ */
+
+#ifndef _EDGEMQTT_H_
+#define _EDGEMQTT_H_
+
+#include "EdgeUnified.h"
+#include "EdgeMQTTBuffer.h"
+#include <PubSubClient.h>
+
+// Default port of the MQTT broker.
+#ifndef ED_MQTT_PORT
+#define ED_MQTT_PORT                          1883
+#endif // !ED_MQTT_PORT
+
+// Default keep-alive [s] of the MQTT session.
+#ifndef ED_MQTT_KEEPALIVE
+#define ED_MQTT_KEEPALIVE                     60
+#endif // !ED_MQTT_KEEPALIVE
+
+// Socket timeout [s] of PubSubClient, which limits the time the connection
+// attempt blocks the loop.
+#ifndef ED_MQTT_SOCKETTIMEOUT
+#define ED_MQTT_SOCKETTIMEOUT                 2
+#endif // !ED_MQTT_SOCKETTIMEOUT
+
+// Default initial delay [ms] and the maximum delay [ms] of the reconnection.
+#ifndef ED_MQTT_RETRYINTERVAL
+#define ED_MQTT_RETRYINTERVAL                 5000
+#endif // !ED_MQTT_RETRYINTERVAL
+#ifndef ED_MQTT_RETRYMAX
+#define ED_MQTT_RETRYMAX                      120000
+#endif // !ED_MQTT_RETRYMAX
+
+// Size [bytes] of the RAM queue that holds the outgoing messages while the
+// session is down. Each message occupies its topic and payload plus 4 bytes.
+#ifndef ED_MQTT_QUEUE_SIZE
+#define ED_MQTT_QUEUE_SIZE                    2048
+#endif // !ED_MQTT_QUEUE_SIZE
+
+// Spool file on the flash where the messages spill when the RAM queue is
+// full, and its size limit [bytes]. Zero limit disables the spool. The file
+// name must be a string literal since the spool is rebuilt into the file
+// with "~" appended.
+#ifndef ED_MQTT_SPOOL_FILE
+#define ED_MQTT_SPOOL_FILE                    "/edgemqtt.spl"
+#endif // !ED_MQTT_SPOOL_FILE
+#ifndef ED_MQTT_SPOOL_SIZE
+#define ED_MQTT_SPOOL_SIZE                    65536
+#endif // !ED_MQTT_SPOOL_SIZE
+
+// Maximum length of the topic and payload of a queued message.
+#ifndef ED_MQTT_MESSAGE_SIZE
+#define ED_MQTT_MESSAGE_SIZE                  256
+#endif // !ED_MQTT_MESSAGE_SIZE
+
+// Format of the publishing topic which is built from the channelid at the
+// start, and the sizes of the topic and the payload buffers.
+#ifndef ED_MQTT_TOPIC_FORMAT
+#define ED_MQTT_TOPIC_FORMAT                  "channels/%s/publish"
+#endif // !ED_MQTT_TOPIC_FORMAT
+#ifndef ED_MQTT_TOPIC_SIZE
+#define ED_MQTT_TOPIC_SIZE                    64
+#endif // !ED_MQTT_TOPIC_SIZE
+#ifndef ED_MQTT_PAYLOAD_SIZE
+#define ED_MQTT_PAYLOAD_SIZE                  128
+#endif // !ED_MQTT_PAYLOAD_SIZE
+
+// Size of the buffer that holds the host of the broker given to
+// PubSubClient while the session is kept.
+#ifndef ED_MQTT_SERVER_SIZE
+#define ED_MQTT_SERVER_SIZE                   64
+#endif // !ED_MQTT_SERVER_SIZE
+
+// Number of the queued messages published in one turn of the process.
+#ifndef ED_MQTT_FLUSH_BATCH
+#define ED_MQTT_FLUSH_BATCH                   8
+#endif // !ED_MQTT_FLUSH_BATCH
+
+// Allocation size of the DynamicJsonDocument for the EdgeMQTT_t serializer.
+#ifndef ED_MQTT_SERIALIZE_BUFFER_SIZE
+#define ED_MQTT_SERIALIZE_BUFFER_SIZE         512
+#endif // !ED_MQTT_SERIALIZE_BUFFER_SIZE
+
+/**
+ * EdgeData of EdgeMQTTDriver. It holds the connection settings for the
+ * MQTT broker and the publishing state.
+ */
+typedef struct {
+  String  server;
+  String  apikey;
+  String  channelid;
+  String  writekey;
+  String  clientid;
+  String  username;
+  String  password;
+  String  hostname;
+  uint16_t  port = ED_MQTT_PORT;
+  uint16_t  keepAlive = ED_MQTT_KEEPALIVE;
+  unsigned long publishInterval = 0;
+  unsigned long retryInterval = ED_MQTT_RETRYINTERVAL;
+  bool  inPublish = false;
+} EdgeMQTT_t;
+
+/**
+ * EdgeMQTTDriver: MQTT EdgeDriver that keeps the session with the broker.
+ * Instead of connecting and disconnecting for each publish, it services
+ * PubSubClient::loop every turn of EdgeUnified::process to keep the session
+ * alive, and reconnects with the exponential backoff of EdgeDriverBase::
+ * retryLater without being called between the attempts. The publish handler
+ * is called every publishInterval regardless of the session. The messages
+ * queued by the enqueue function are stored while the session is down and
+ * are flushed in batches of ED_MQTT_FLUSH_BATCH messages per turn once it
+ * is re-established. When the RAM queue is full, the messages spill to the
+ * spool file on the flash in order, and the deep sleep of the duty cycle
+ * moves the RAM queue into the spool.
+ * The topic is built when the driver starts, and the payload is formatted
+ * into the buffer of the driver with the field functions, so formatting
+ * and queuing the messages in the steady state do not allocate the heap.
+ * The client given to the driver should disable the Nagle algorithm once
+ * connected, e.g. WiFiClient::setNoDelay in the onConnect handler. Without
+ * it, a publish that follows another within the round trip waits for the
+ * delayed ACK of the broker, up to 40 ms on Linux.
+ * The EdgeData includes class objects, so EdgeMQTTDriver provides its own
+ * serializer and deserializer for the persistence.
+ */
+class EdgeMQTTDriver : public EdgeDriver<EdgeMQTT_t> {
+ public:
+  typedef std::function<void(EdgeMQTTDriver&)>  EdgeMQTTHandlerT;
+
+  explicit EdgeMQTTDriver(Client& client) {
+    _mqttClient.setClient(client);
+    _cbStart = [this]() { _start(); };
+    _cbProcess = [this]() { _process(); };
+    _cbEnd = [this]() { _end(); };
+    _cbFlush = [this]() { _spoolQueue(); };
+    serializer([this](JsonObject& json) { _serialize(json); }, [this](JsonObject& json) { _deserialize(json); }, ED_MQTT_SERIALIZE_BUFFER_SIZE);
+    gauge(PSTR("mqtt_queued_messages"), PSTR("Messages waiting to be published."), [this]() { return static_cast<double>(queued()); });
+    counter(PSTR("mqtt_dropped_messages_total"), PSTR("Messages dropped by the full queue."), [this]() { return static_cast<double>(dropped()); });
+  }
+  ~EdgeMQTTDriver() {
+    // The end callback and the serializer refer to _mqttClient and the
+    // queue, which ~EdgeDriverBase would outlive.
+    _dispose();
+  }
+
+  PubSubClient& client(void) { return _mqttClient; }
+  bool  connected(void) { return _mqttClient.connected(); }
+  unsigned long dropped(void) const { return _dropped; }
+  void  onConnect(EdgeMQTTHandlerT handler) { _onConnect = handler; }
+  void  onPublish(EdgeMQTTHandlerT handler) { _onPublish = handler; }
+  void  onStart(EdgeDriverHandlerT handler) { _onStart = handler; }
+  const char* payload(void) const { return _payload.c_str(); }
+  size_t  queued(void) const { return _queue.count() + _spoolCount; }
+  const char* topic(void) const { return _topic; }
+
+  /**
+   * Appends a field to the payload buffer in the form of the ThingSpeak
+   * field, e.g. `field1=-64&field2=21.50`. The payload is cleared when it
+   * has been queued or published by enqueue(void) or publish(void).
+   * @param  n      Field number.
+   * @param  value  Value of the field.
+   * @param  decimals Number of the decimal places of the float value.
+   * @return true   Appended.
+   * @return false  The payload buffer is full. The field is not appended.
+   */
+  template<typename T, typename std::enable_if<std::is_integral<T>::value, std::nullptr_t>::type = nullptr>
+  bool  field(const uint8_t n, const T value) {
+    return _field(_payload.field(n, value), n);
+  }
+
+  bool  field(const uint8_t n, const double value, const uint8_t decimals = 2) {
+    return _field(_payload.field(n, value, decimals), n);
+  }
+
+  bool  field(const uint8_t n, const char* value) {
+    return _field(_payload.field(n, value), n);
+  }
+
+  /**
+   * Queues the payload formatted by the field functions with the topic of
+   * the driver, and clears the payload.
+   */
+  bool  enqueue(void) {
+    bool  rc = enqueue(_topic, _payload.c_str());
+    _payload.clear();
+    return rc;
+  }
+
+  /**
+   * Queues the message to be published. The queued messages are published in
+   * the queued order by the process while the session is established. Once
+   * the message has spilled to the spool file, the following messages are
+   * also spooled until the spool drains to keep the order.
+   * @param  topic    Topic to be published.
+   * @param  payload  Payload of the message.
+   * @return true   Queued.
+   * @return false  The message is too long, or both the RAM queue and the
+   * spool are full. The message is dropped.
+   */
+  bool  enqueue(const char* topic, const char* payload) {
+    size_t  tLen = strlen(topic);
+    size_t  pLen = strlen(payload);
+
+    if (tLen + pLen + 1 <= sizeof(_message)) {
+      if (!_spoolCount && _queue.push(topic, tLen, payload, pLen))
+        return true;
+      if (_spool(topic, tLen, payload, pLen))
+        return true;
+    }
+    _dropped++;
+    ED_DBG("MQTT queue full, message dropped\n");
+    return false;
+  }
+
+  /**
+   * Publishes the message through the established session.
+   * @param  topic    Topic to be published.
+   * @param  payload  Payload of the message.
+   * @return true   Published.
+   * @return false  The session is not established or publishing failed.
+   */
+  bool  publish(const char* topic, const char* payload) {
+    if (!_mqttClient.connected())
+      return false;
+    data.inPublish = _mqttClient.publish(topic, payload);
+    if (!data.inPublish)
+      ED_DBG("MQTT publishing failed:%d\n", _mqttClient.state());
+    else
+      _markPublished();
+    return data.inPublish;
+  }
+
+  /**
+   * Publishes the payload formatted by the field functions with the topic
+   * of the driver, and clears the payload.
+   */
+  bool  publish(void) {
+    bool  rc = publish(_topic, _payload.c_str());
+    _payload.clear();
+    return rc;
+  }
+
+ protected:
+  bool  _field(const bool appended, const uint8_t n) {
+    if (!appended)
+      ED_DBG("MQTT payload full, field%u dropped\n", n);
+    return appended;
+  }
+
+  void  _start(void) {
+    _mqttClient.disconnect();
+    // PubSubClient keeps the pointer to the host, which must outlive the
+    // reassignment of data.server until the next start.
+    strncpy(_server, data.server.c_str(), sizeof(_server) - 1);
+    _server[sizeof(_server) - 1] = '\0';
+    if (data.server.length() >= sizeof(_server))
+      ED_DBG("MQTT server %s truncated\n", data.server.c_str());
+    _mqttClient.setServer(_server, data.port);
+    _mqttClient.setKeepAlive(data.keepAlive);
+    _mqttClient.setSocketTimeout(ED_MQTT_SOCKETTIMEOUT);
+    snprintf(_topic, sizeof(_topic), ED_MQTT_TOPIC_FORMAT, data.channelid.c_str());
+    _payload.clear();
+    data.inPublish = false;
+    // The retry delay does not exceed the publishInterval so that the
+    // publish handler keeps queuing the messages while the broker is down.
+    unsigned long retryMax = ED_MQTT_RETRYMAX;
+    if (data.publishInterval)
+      retryMax = std::min(retryMax, data.publishInterval);
+    retryPolicy(data.retryInterval, retryMax);
+    _published = millis() - data.publishInterval;
+    if (!_spoolCount)
+      _adoptSpool();
+    setEdgeInterval(0);
+    if (_onStart)
+      _onStart();
+  }
+
+  void  _process(void) {
+    if (!data.server.length())
+      return;
+
+    if (data.publishInterval && millis() - _published >= data.publishInterval) {
+      _published = millis();
+      if (_onPublish)
+        _onPublish(*this);
+    }
+
+    if (_mqttClient.loop() || _connect())
+      _flush();
+  }
+
+  /**
+   * Attempts to reconnect the lost session. A failed attempt schedules the
+   * next one with EdgeDriverBase::retryLater, so the process is not called
+   * until the backoff delay has passed.
+   * @return true   The session has been established.
+   */
+  bool  _connect(void) {
+    data.inPublish = false;
+    ED_DBG("MQTT connecting %s\n", data.server.c_str());
+    if (!_mqttClient.connect(data.clientid.c_str(), data.username.c_str(), data.password.c_str())) {
+      retryLater();
+      ED_DBG("MQTT connection failed:%d, retry %d\n", _mqttClient.state(), getRetries());
+      return false;
+    }
+    succeeded();
+    data.inPublish = true;
+    if (_onConnect)
+      _onConnect(*this);
+    return true;
+  }
+
+  /**
+   * Publishes the queued messages up to ED_MQTT_FLUSH_BATCH in the queued
+   * order, the RAM queue first and then the spool. A message leaves the
+   * queue only after it has been published.
+   */
+  void  _flush(void) {
+    File  spool;
+    uint8_t header[sizeof(uint16_t) * 2];
+
+    for (uint8_t n = 0; n < ED_MQTT_FLUSH_BATCH; n++) {
+      size_t  tLen, pLen;
+      if (_queue.count()) {
+        if (!_queue.peek(_message, sizeof(_message), tLen, pLen)) {
+          ED_DBG("MQTT queue broken, %u messages dropped\n", _queue.count());
+          _dropped += _queue.count();
+          _queue.clear();
+          break;
+        }
+      }
+      else if (_spoolCount) {
+        if (!spool) {
+          spool = AUTOCONNECT_APPLIED_FILESYSTEM.open(ED_MQTT_SPOOL_FILE, "r");
+          if (!spool || !spool.seek(_spoolRead)) {
+            ED_DBG("MQTT spool lost\n");
+            _clearSpool();
+            break;
+          }
+        }
+        bool  valid = spool.read(header, sizeof(header)) == sizeof(header);
+        tLen = header[0] | (header[1] << 8);
+        pLen = header[2] | (header[3] << 8);
+        valid = valid && tLen + pLen + 1 <= sizeof(_message);
+        valid = valid && spool.read(_message, tLen) == tLen;
+        valid = valid && spool.read(_message + tLen + 1, pLen) == pLen;
+        if (!valid) {
+          ED_DBG("MQTT spool broken, %u messages dropped\n", _spoolCount);
+          _dropped += _spoolCount;
+          spool.close();
+          _clearSpool();
+          break;
+        }
+      }
+      else
+        break;
+
+      _message[tLen] = '\0';
+      data.inPublish = _mqttClient.publish(reinterpret_cast<const char*>(_message), _message + tLen + 1, pLen, false);
+      if (!data.inPublish) {
+        ED_DBG("MQTT publishing failed:%d\n", _mqttClient.state());
+        break;
+      }
+      _markPublished();
+
+      if (_queue.count())
+        _queue.pop();
+      else {
+        _spoolRead += sizeof(header) + tLen + pLen;
+        if (!--_spoolCount) {
+          spool.close();
+          _clearSpool();
+        }
+      }
+    }
+
+    if (spool)
+      spool.close();
+  }
+
+  /**
+   * Appends the message to the spool file. The file system must have been
+   * mounted by the sketch or AutoConnect.
+   */
+  bool  _spool(const char* topic, size_t tLen, const char* payload, size_t pLen) {
+    const size_t  rLen = EdgeMQTTQueue<ED_MQTT_QUEUE_SIZE>::HEADER_SIZE + tLen + pLen;
+    if (_spoolSize + rLen > ED_MQTT_SPOOL_SIZE)
+      return false;
+    if (!AutoConnectFS::_isMounted(&AUTOCONNECT_APPLIED_FILESYSTEM))
+      return false;
+
+    File  spool = AUTOCONNECT_APPLIED_FILESYSTEM.open(ED_MQTT_SPOOL_FILE, "a");
+    if (!spool)
+      return false;
+    size_t  wLen = _spoolWrite(spool, topic, tLen, payload, pLen);
+    spool.close();
+    if (wLen != rLen) {
+      // The partial record cannot be read back, so the spool stops accepting.
+      _spoolSize = ED_MQTT_SPOOL_SIZE;
+      return false;
+    }
+    _spoolSize += wLen;
+    _spoolCount++;
+    return true;
+  }
+
+  /**
+   * Writes a record of the message in the same form as EdgeMQTTQueue.
+   * @return Size of the written record.
+   */
+  size_t  _spoolWrite(File& spool, const char* topic, size_t tLen, const char* payload, size_t pLen) {
+    const uint8_t header[EdgeMQTTQueue<ED_MQTT_QUEUE_SIZE>::HEADER_SIZE] = {
+      static_cast<uint8_t>(tLen), static_cast<uint8_t>(tLen >> 8),
+      static_cast<uint8_t>(pLen), static_cast<uint8_t>(pLen >> 8)
+    };
+    size_t  wLen = spool.write(header, sizeof(header));
+    wLen += spool.write(reinterpret_cast<const uint8_t*>(topic), tLen);
+    wLen += spool.write(reinterpret_cast<const uint8_t*>(payload), pLen);
+    return wLen;
+  }
+
+  /**
+   * Moves the messages of the RAM queue into the spool before the deep
+   * sleep, which loses the RAM. The queued messages are older than the
+   * spooled ones, so the spool is rebuilt into ED_MQTT_SPOOL_FILE "~" with
+   * the queued messages first and then replaces the spool. The messages
+   * beyond ED_MQTT_SPOOL_SIZE are left in the queue.
+   */
+  void  _spoolQueue(void) {
+    if (!_queue.count())
+      return;
+    if (!AutoConnectFS::_isMounted(&AUTOCONNECT_APPLIED_FILESYSTEM)) {
+      ED_DBG("MQTT %u queued messages not spooled\n", _queue.count());
+      return;
+    }
+
+    File  rebuilt = AUTOCONNECT_APPLIED_FILESYSTEM.open(ED_MQTT_SPOOL_FILE "~", "w");
+    if (!rebuilt)
+      return;
+    const size_t  unread = _spoolSize - _spoolRead;
+    size_t  offset = 0;
+    size_t  count = 0;
+    size_t  tLen, pLen;
+    bool  valid = true;
+    while (_queue.peek(_message, sizeof(_message), tLen, pLen, offset)) {
+      size_t  rLen = EdgeMQTTQueue<ED_MQTT_QUEUE_SIZE>::HEADER_SIZE + tLen + pLen;
+      if (offset + rLen + unread > ED_MQTT_SPOOL_SIZE)
+        break;
+      if (_spoolWrite(rebuilt, reinterpret_cast<const char*>(_message), tLen, reinterpret_cast<const char*>(_message) + tLen + 1, pLen) != rLen) {
+        valid = false;
+        break;
+      }
+      offset += rLen;
+      count++;
+    }
+
+    // The spooled messages follow the queued ones
+    if (valid && count && _spoolCount) {
+      File  spool = AUTOCONNECT_APPLIED_FILESYSTEM.open(ED_MQTT_SPOOL_FILE, "r");
+      valid = spool && spool.seek(_spoolRead);
+      for (size_t copied = 0; valid && copied < unread;) {
+        size_t  len = spool.read(_message, std::min(sizeof(_message), unread - copied));
+        valid = len && rebuilt.write(_message, len) == len;
+        copied += len;
+      }
+      if (spool)
+        spool.close();
+    }
+    rebuilt.close();
+
+    if (!valid || !count) {
+      AUTOCONNECT_APPLIED_FILESYSTEM.remove(ED_MQTT_SPOOL_FILE "~");
+      ED_DBG("MQTT %u queued messages not spooled\n", _queue.count());
+      return;
+    }
+    AUTOCONNECT_APPLIED_FILESYSTEM.remove(ED_MQTT_SPOOL_FILE);
+    AUTOCONNECT_APPLIED_FILESYSTEM.rename(ED_MQTT_SPOOL_FILE "~", ED_MQTT_SPOOL_FILE);
+    _spoolCount += count;
+    _spoolRead = 0;
+    _spoolSize = offset + unread;
+    for (size_t n = 0; n < count; n++)
+      _queue.pop();
+    ED_DBG("MQTT %u queued messages spooled, %u left\n", count, _queue.count());
+  }
+
+  /**
+   * Adopts the spool file left by the previous run so that the messages
+   * spooled before the reset are not lost. The messages whose publishing
+   * had been completed before the reset may be published again.
+   */
+  void  _adoptSpool(void) {
+    if (!AutoConnectFS::_isMounted(&AUTOCONNECT_APPLIED_FILESYSTEM))
+      return;
+    File  spool = AUTOCONNECT_APPLIED_FILESYSTEM.open(ED_MQTT_SPOOL_FILE, "r");
+    if (!spool)
+      return;
+
+    uint8_t header[sizeof(uint16_t) * 2];
+    size_t  size = spool.size();
+    while (_spoolSize + sizeof(header) <= size) {
+      if (spool.read(header, sizeof(header)) != sizeof(header))
+        break;
+      size_t  bLen = (header[0] | (header[1] << 8)) + (header[2] | (header[3] << 8));
+      if (_spoolSize + sizeof(header) + bLen > size || !spool.seek(_spoolSize + sizeof(header) + bLen))
+        break;
+      _spoolSize += sizeof(header) + bLen;
+      _spoolCount++;
+    }
+    spool.close();
+    if (!_spoolCount)
+      _clearSpool();
+    ED_DBG("MQTT %u spooled messages adopted\n", _spoolCount);
+  }
+
+  void  _clearSpool(void) {
+    AUTOCONNECT_APPLIED_FILESYSTEM.remove(ED_MQTT_SPOOL_FILE);
+    _spoolCount = 0;
+    _spoolRead = 0;
+    _spoolSize = 0;
+  }
+
+  // Marks the first publish on the boot timeline of EdgeUnified.
+  void  _markPublished(void) {
+    if (_edge)
+      _edge->bootMark(PSTR("first publish"), this);
+  }
+
+  void  _end(void) {
+    _mqttClient.disconnect();
+    data.inPublish = false;
+  }
+
+  void  _serialize(JsonObject& json) {
+    json[F("server")] = data.server;
+    json[F("apikey")] = data.apikey;
+    json[F("channelid")] = data.channelid;
+    json[F("writekey")] = data.writekey;
+    json[F("clientid")] = data.clientid;
+    json[F("username")] = data.username;
+    json[F("password")] = data.password;
+    json[F("hostname")] = data.hostname;
+    json[F("port")] = data.port;
+    json[F("keepAlive")] = data.keepAlive;
+    json[F("publishInterval")] = data.publishInterval;
+  }
+
+  void  _deserialize(JsonObject& json) {
+    data.server = json[F("server")].as<String>();
+    data.apikey = json[F("apikey")].as<String>();
+    data.channelid = json[F("channelid")].as<String>();
+    data.writekey = json[F("writekey")].as<String>();
+    data.clientid = json[F("clientid")].as<String>();
+    data.username = json[F("username")].as<String>();
+    data.password = json[F("password")].as<String>();
+    data.hostname = json[F("hostname")].as<String>();
+    data.port = json[F("port")] | ED_MQTT_PORT;
+    data.keepAlive = json[F("keepAlive")] | ED_MQTT_KEEPALIVE;
+    data.publishInterval = json[F("publishInterval")].as<unsigned long>();
+  }
+
+  PubSubClient  _mqttClient;                            /**< MQTT client keeping the session */
+  EdgeMQTTHandlerT  _onConnect;                         /**< Called when the session is established */
+  EdgeMQTTHandlerT  _onPublish;                         /**< Called every publishInterval */
+  EdgeDriverHandlerT  _onStart;                         /**< Called at the end of the start */
+  unsigned long _published = 0;                         /**< Time of the last publish */
+  unsigned long _dropped = 0;                           /**< Number of the dropped messages */
+  EdgeMQTTQueue<ED_MQTT_QUEUE_SIZE> _queue;             /**< RAM queue of the outgoing messages */
+  char    _server[ED_MQTT_SERVER_SIZE] = { '\0' };      /**< Host of the broker given to PubSubClient */
+  char    _topic[ED_MQTT_TOPIC_SIZE] = { '\0' };        /**< Topic built from the channelid */
+  EdgeMQTTPayload<ED_MQTT_PAYLOAD_SIZE> _payload;       /**< Payload formatted by the field functions */
+  uint8_t _message[ED_MQTT_MESSAGE_SIZE];               /**< Topic and payload being published */
+  size_t  _spoolCount = 0;                              /**< Number of the messages in the spool */
+  size_t  _spoolRead = 0;                               /**< Offset of the oldest spooled message */
+  size_t  _spoolSize = 0;                               /**< Size of the spool file */
+};
+
+#endif // !_EDGEMQTT_H_
@@ -0,0 +1,185 @@
+/**
+ *	Declaration of EdgeMQTTPayload and EdgeMQTTQueue classes.
+ *	@file	EdgeMQTTBuffer.h
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ */
+
+#ifndef _EDGEMQTTBUFFER_H_
+#define _EDGEMQTTBUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * EdgeMQTTPayload: Fixed buffer that formats the payload in the form of the
+ * ThingSpeak fields, e.g. `field1=-64&field2=21.50`.
+ * It depends only on the standard library so that extras/hosttest can
+ * exercise it without the Arduino core.
+ * @param  N  Size of the buffer including the terminator.
+ */
+template<size_t N>
+class EdgeMQTTPayload {
+ public:
+  EdgeMQTTPayload() { clear(); }
+  ~EdgeMQTTPayload() {}
+
+  const char* c_str(void) const { return _buffer; }
+  void  clear(void) { _length = 0; _buffer[0] = '\0'; }
+  size_t  length(void) const { return _length; }
+
+  /**
+   * Appends a field to the payload.
+   * @param  n      Field number.
+   * @param  value  Value of the field.
+   * @param  decimals Number of the decimal places of the float value.
+   * @return true   Appended.
+   * @return false  The buffer is full. The field is not appended.
+   */
+  template<typename T, typename std::enable_if<std::is_integral<T>::value, std::nullptr_t>::type = nullptr>
+  bool  field(const uint8_t n, const T value) {
+    return _field("%sfield%u=%ld", n, static_cast<long>(value));
+  }
+
+  bool  field(const uint8_t n, const double value, const uint8_t decimals = 2) {
+    return _field("%sfield%u=%.*f", n, static_cast<int>(decimals), value);
+  }
+
+  bool  field(const uint8_t n, const char* value) {
+    return _field("%sfield%u=%s", n, value);
+  }
+
+ protected:
+  template<typename... Args>
+  bool  _field(const char* format, const uint8_t n, Args... args) {
+    size_t  room = N - _length;
+    int len = snprintf(_buffer + _length, room, format, _length ? "&" : "", static_cast<unsigned int>(n), args...);
+    if (len < 0 || static_cast<size_t>(len) >= room) {
+      _buffer[_length] = '\0';
+      return false;
+    }
+    _length += len;
+    return true;
+  }
+
+  char    _buffer[N];                                   /**< Formatted payload */
+  size_t  _length;                                      /**< Length of the formatted payload */
+};
+
+/**
+ * EdgeMQTTQueue: Ring buffer of the outgoing messages. Each message is
+ * stored as the lengths of the topic and the payload in 4 bytes followed
+ * by the topic and the payload without the terminators, so the messages
+ * occupy only their own lengths.
+ * It depends only on the standard library so that extras/hosttest can
+ * exercise it without the Arduino core.
+ * @param  N  Size of the buffer [bytes].
+ */
+template<size_t N>
+class EdgeMQTTQueue {
+ public:
+  static const size_t HEADER_SIZE = sizeof(uint16_t) * 2;
+
+  EdgeMQTTQueue() {}
+  ~EdgeMQTTQueue() {}
+
+  size_t  count(void) const { return _count; }
+  size_t  used(void) const { return _used; }
+  void  clear(void) { _head = _tail = _used = _count = 0; }
+
+  /**
+   * Stores the message at the end of the queue.
+   * @return true   Stored.
+   * @return false  The queue has no room for the message.
+   */
+  bool  push(const char* topic, const size_t tLen, const char* payload, const size_t pLen) {
+    const uint8_t header[HEADER_SIZE] = {
+      static_cast<uint8_t>(tLen), static_cast<uint8_t>(tLen >> 8),
+      static_cast<uint8_t>(pLen), static_cast<uint8_t>(pLen >> 8)
+    };
+    if (tLen > UINT16_MAX || pLen > UINT16_MAX || N - _used < HEADER_SIZE + tLen + pLen)
+      return false;
+    _put(header, sizeof(header));
+    _put(topic, tLen);
+    _put(payload, pLen);
+    _count++;
+    return true;
+  }
+
+  /**
+   * Copies the message into the buffer as the topic with the terminator
+   * followed by the payload without the terminator.
+   * @param  message  Buffer of the message.
+   * @param  size     Size of the buffer.
+   * @param  tLen     Length of the topic.
+   * @param  pLen     Length of the payload.
+   * @param  offset   Offset [bytes] of the message from the oldest one. The
+   * next message follows at the offset plus HEADER_SIZE, tLen and pLen.
+   * @return true   Copied.
+   * @return false  No message is at the offset, or the message exceeds the
+   * buffer.
+   */
+  bool  peek(uint8_t* message, const size_t size, size_t& tLen, size_t& pLen, const size_t offset = 0) const {
+    if (offset >= _used)
+      return false;
+    _lengths(offset, tLen, pLen);
+    if (tLen + pLen + 1 > size)
+      return false;
+    _get(offset + HEADER_SIZE, message, tLen);
+    message[tLen] = '\0';
+    _get(offset + HEADER_SIZE + tLen, message + tLen + 1, pLen);
+    return true;
+  }
+
+  /**
+   * Removes the oldest message.
+   */
+  void  pop(void) {
+    if (!_count)
+      return;
+    size_t  tLen, pLen;
+    _lengths(0, tLen, pLen);
+    size_t  rLen = HEADER_SIZE + tLen + pLen;
+    _tail = (_tail + rLen) % N;
+    _used -= rLen;
+    _count--;
+  }
+
+ protected:
+  void  _lengths(const size_t offset, size_t& tLen, size_t& pLen) const {
+    uint8_t header[HEADER_SIZE];
+    _get(offset, header, sizeof(header));
+    tLen = header[0] | (header[1] << 8);
+    pLen = header[2] | (header[3] << 8);
+  }
+
+  void  _get(const size_t offset, uint8_t* dst, size_t len) const {
+    size_t  index = (_tail + offset) % N;
+    while (len--) {
+      *dst++ = _buffer[index];
+      index = (index + 1) % N;
+    }
+  }
+
+  void  _put(const void* src, size_t len) {
+    const uint8_t*  p = static_cast<const uint8_t*>(src);
+    _used += len;
+    while (len--) {
+      _buffer[_head] = *p++;
+      _head = (_head + 1) % N;
+    }
+  }
+
+  uint8_t _buffer[N];                                   /**< Stored messages */
+  size_t  _head = 0;                                    /**< Index where the next message is stored */
+  size_t  _tail = 0;                                    /**< Index of the oldest message */
+  size_t  _used = 0;                                    /**< Bytes used by the messages */
+  size_t  _count = 0;                                   /**< Number of the messages */
+};
+
+#endif // !_EDGEMQTTBUFFER_H_
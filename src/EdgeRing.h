@@ -0,0 +1,64 @@
+/**
+ *	Declaration of EdgeRing class.
+ *	@file	EdgeRing.h
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ */
+
+#ifndef _EDGERING_H_
+#define _EDGERING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// The Arduino core gives IRAM_ATTR, so this header should be included
+// after Arduino.h to place push in IRAM.
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+/**
+ * EdgeRing: Lock-free ring buffer with a single producer and a single
+ * consumer. The producer may be an interrupt service routine, it never
+ * blocks and reports the overflow instead.
+ * It depends only on the standard library so that extras/hosttest can
+ * exercise it without the Arduino core.
+ * @param  T  Type of the element.
+ * @param  N  Number of the elements, a power of 2.
+ */
+template<typename T, size_t N>
+class EdgeRing {
+ public:
+  EdgeRing() : _head(0), _tail(0) {
+    static_assert(N && !(N & (N - 1)), "EdgeRing size must be a power of 2");
+  }
+  ~EdgeRing() {}
+
+  bool IRAM_ATTR  push(const T& element) {
+    uint32_t  head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) >= N)
+      return false;
+    _ring[head & (N - 1)] = element;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool  pop(T& element) {
+    uint32_t  tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire))
+      return false;
+    element = _ring[tail & (N - 1)];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+ protected:
+  T _ring[N];                                           /**< Elements */
+  std::atomic<uint32_t> _head;                          /**< Count of the pushed elements */
+  std::atomic<uint32_t> _tail;                          /**< Count of the popped elements */
+};
+
+#endif // !_EDGERING_H_
@@ -0,0 +1,130 @@
+/**
+ *	Declaration of EdgeSampler class.
+ *	@file	EdgeSampler.h
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ */
+
+#ifndef _EDGESAMPLER_H_
+#define _EDGESAMPLER_H_
+
+#include "EdgeUnified.h"
+
+// Default sampling interval [ms].
+#ifndef ED_SAMPLER_INTERVAL
+#define ED_SAMPLER_INTERVAL                   20
+#endif // !ED_SAMPLER_INTERVAL
+
+// Default smoothing factor of the exponentially weighted moving average.
+#ifndef ED_SAMPLER_ALPHA
+#define ED_SAMPLER_ALPHA                      0.25f
+#endif // !ED_SAMPLER_ALPHA
+
+/**
+ * EdgeData of EdgeSampler.
+ */
+typedef struct {
+  unsigned long interval = ED_SAMPLER_INTERVAL;         /**< Sampling interval */
+  float alpha = ED_SAMPLER_ALPHA;                       /**< Smoothing factor of EWMA */
+} EdgeSampler_t;
+
+/**
+ * EdgeSampler: Generic sampling EdgeDriver. It takes one sample per turn of
+ * the EdgeDriver::process at its own interval with the reader function into
+ * a ring buffer of N samples, and keeps the mean, minimum, maximum and the
+ * exponentially weighted moving average incrementally. The consumers of the
+ * samples get the aggregates instantly without a blocking multi-sample loop.
+ * All instances share EdgeSampler_t, so each instance is named by the
+ * constructor instead of the EdgeData type. The name keys the persistence
+ * file, the REST API and the metrics, and must be unique in EdgeUnified.
+ * @param  N  Number of samples in the window of the aggregates.
+ */
+template<size_t N>
+class EdgeSampler : public EdgeDriver<EdgeSampler_t> {
+ public:
+  typedef std::function<float(void)>  EdgeSamplerReaderT;
+
+  EdgeSampler(const char* name, EdgeSamplerReaderT reader) : _reader(reader) {
+    static_assert(N > 0, "EdgeSampler requires at least one sample");
+    _setType(String(name));
+    _cbStart = [this]() { reset(); setEdgeInterval(data.interval); };
+    _cbProcess = [this]() { sample(); };
+  }
+  ~EdgeSampler() {}
+
+  // Aggregates of the samples in the window
+  size_t  count(void) const { return _count; }
+  float ewma(void) const { return _ewma; }
+  float last(void) const { return _count ? _ring[(_head + N - 1) % N] : 0.0f; }
+  float maximum(void) const { return _max; }
+  float mean(void) const { return _count ? _sum / _count : 0.0f; }
+  float minimum(void) const { return _min; }
+
+  /**
+   * Clears the samples and the aggregates.
+   */
+  void  reset(void) {
+    _count = 0;
+    _head = 0;
+    _sum = 0.0f;
+    _min = _max = _ewma = 0.0f;
+  }
+
+  /**
+   * Takes a sample with the reader and updates the aggregates. The minimum
+   * and the maximum are rescanned only when the sample that is leaving the
+   * window was one of them.
+   */
+  void  sample(void) {
+    if (!_reader)
+      return;
+
+    float value = _reader();
+    bool  rescan = false;
+    if (_count == N) {
+      float evicted = _ring[_head];
+      _sum -= evicted;
+      rescan = evicted <= _min || evicted >= _max;
+    }
+    else
+      _count++;
+
+    _ring[_head] = value;
+    _head = (_head + 1) % N;
+    _sum += value;
+
+    if (_count == 1) {
+      _min = _max = _ewma = value;
+      return;
+    }
+
+    _ewma += data.alpha * (value - _ewma);
+    if (rescan) {
+      // Rescanning also cancels the rounding error accumulated in the sum.
+      _min = _max = _sum = _ring[0];
+      for (size_t i = 1; i < N; i++) {
+        _min = std::min(_min, _ring[i]);
+        _max = std::max(_max, _ring[i]);
+        _sum += _ring[i];
+      }
+    }
+    else {
+      _min = std::min(_min, value);
+      _max = std::max(_max, value);
+    }
+  }
+
+ protected:
+  EdgeSamplerReaderT  _reader;                          /**< Sensor read function */
+  float   _ring[N];                                     /**< Ring buffer of the samples */
+  size_t  _count = 0;                                   /**< Number of the samples in the window */
+  size_t  _head = 0;                                    /**< Index where the next sample is stored */
+  float   _sum = 0.0f;                                  /**< Sum of the samples in the window */
+  float   _min = 0.0f;                                  /**< Minimum of the samples in the window */
+  float   _max = 0.0f;                                  /**< Maximum of the samples in the window */
+  float   _ewma = 0.0f;                                 /**< Exponentially weighted moving average */
+};
+
+#endif // !_EDGESAMPLER_H_
@@ -0,0 +1,185 @@
+/**
+ *	Declaration of EdgeUnified service drivers.
+ *	@file	EdgeServices.h
+ *	@author	hieromon@gmail.com
+ *	@version	0.9.1
+ *	@date	2022-08-24
+ *	@copyright	MIT license.
+ */
+
+#ifndef _EDGESERVICES_H_
+#define _EDGESERVICES_H_
+
+#include "EdgeUnified.h"
+#if defined(ARDUINO_ARCH_ESP8266)
+#include <ESP8266mDNS.h>
+#endif
+
+// Priorities of the service drivers. The portal service precedes the other
+// EdgeDrivers so that the HTTP requests are served first in each loop.
+#ifndef ED_SERVICE_PORTAL_PRIORITY
+#define ED_SERVICE_PORTAL_PRIORITY            224
+#endif // !ED_SERVICE_PORTAL_PRIORITY
+#ifndef ED_SERVICE_MDNS_PRIORITY
+#define ED_SERVICE_MDNS_PRIORITY              64
+#endif // !ED_SERVICE_MDNS_PRIORITY
+#ifndef ED_SERVICE_WIFI_PRIORITY
+#define ED_SERVICE_WIFI_PRIORITY              32
+#endif // !ED_SERVICE_WIFI_PRIORITY
+
+// Interval [ms] of AutoConnect::handleClient while no HTTP request arrives.
+#ifndef ED_SERVICE_PORTAL_IDLEINTERVAL
+#define ED_SERVICE_PORTAL_IDLEINTERVAL        10
+#endif // !ED_SERVICE_PORTAL_IDLEINTERVAL
+
+// Period [ms] during which the portal service keeps calling handleClient
+// every loop after the last HTTP request was served.
+#ifndef ED_SERVICE_PORTAL_BUSYHOLD
+#define ED_SERVICE_PORTAL_BUSYHOLD            1000
+#endif // !ED_SERVICE_PORTAL_BUSYHOLD
+
+// Duration [us] of handleClient regarded as having served an HTTP request.
+#ifndef ED_SERVICE_PORTAL_BUSYTHRESHOLD
+#define ED_SERVICE_PORTAL_BUSYTHRESHOLD       1000
+#endif // !ED_SERVICE_PORTAL_BUSYTHRESHOLD
+
+// Interval [ms] of MDNS.update.
+#ifndef ED_SERVICE_MDNS_INTERVAL
+#define ED_SERVICE_MDNS_INTERVAL              20
+#endif // !ED_SERVICE_MDNS_INTERVAL
+
+// Interval [ms] of the WiFi connection check, and the initial and the
+// maximum delay [ms] of the reconnection attempts.
+#ifndef ED_SERVICE_WIFI_INTERVAL
+#define ED_SERVICE_WIFI_INTERVAL              1000
+#endif // !ED_SERVICE_WIFI_INTERVAL
+#ifndef ED_SERVICE_WIFI_RECONNECTDELAY
+#define ED_SERVICE_WIFI_RECONNECTDELAY        5000
+#endif // !ED_SERVICE_WIFI_RECONNECTDELAY
+#ifndef ED_SERVICE_WIFI_RECONNECTMAX
+#define ED_SERVICE_WIFI_RECONNECTMAX          60000
+#endif // !ED_SERVICE_WIFI_RECONNECTMAX
+
+/**
+ * EdgeData of EdgePortalService.
+ */
+typedef struct {
+  unsigned long idleInterval = ED_SERVICE_PORTAL_IDLEINTERVAL;  /**< handleClient interval while idle */
+  unsigned long busyHold = ED_SERVICE_PORTAL_BUSYHOLD;          /**< Period to keep busy after a request */
+  unsigned long busy = 0;                                       /**< Time when the last request was served */
+} EdgePortalService_t;
+
+/**
+ * EdgePortalService: A service driver that calls AutoConnect::handleClient
+ * as an EdgeDriver. It calls handleClient every loop while the HTTP requests
+ * are arriving and backs off to the idleInterval when the portal becomes
+ * idle. Attaching it also binds the AutoConnect instance to EdgeUnified,
+ * so the loop function only needs to call EdgeUnified::process.
+ */
+class EdgePortalService : public EdgeDriver<EdgePortalService_t> {
+ public:
+  explicit EdgePortalService(AutoConnect& portal) : _portal(portal) {
+    _cbStart = [this]() { _start(); };
+    _cbProcess = [this]() { _process(); };
+    setPriority(ED_SERVICE_PORTAL_PRIORITY);
+  }
+  ~EdgePortalService() {}
+
+ protected:
+  void  _start(void) {
+    if (_edge)
+      _edge->portal(_portal);
+    data.busy = millis();
+    setEdgeInterval(0);
+  }
+
+  void  _process(void) {
+    unsigned long tm = micros();
+    _portal.handleClient();
+    if (micros() - tm >= ED_SERVICE_PORTAL_BUSYTHRESHOLD) {
+      data.busy = millis();
+      if (_interval)
+        setEdgeInterval(0);
+    }
+    else if (!_interval && millis() - data.busy > data.busyHold)
+      setEdgeInterval(data.idleInterval);
+  }
+
+  AutoConnect&  _portal;                                /**< AutoConnect served */
+};
+
+/**
+ * EdgeData of EdgeMDNSService.
+ */
+typedef struct {
+  unsigned long interval = ED_SERVICE_MDNS_INTERVAL;    /**< MDNS.update interval */
+} EdgeMDNSService_t;
+
+/**
+ * EdgeMDNSService: A service driver that keeps the mDNS responder up to
+ * date. The ESP32 mDNS responder runs in its own task, so the service does
+ * nothing on ESP32.
+ */
+class EdgeMDNSService : public EdgeDriver<EdgeMDNSService_t> {
+ public:
+  EdgeMDNSService() {
+    _cbStart = [this]() { setEdgeInterval(data.interval); };
+#if defined(ARDUINO_ARCH_ESP8266)
+    _cbProcess = []() { MDNS.update(); };
+#endif
+    setPriority(ED_SERVICE_MDNS_PRIORITY);
+  }
+  ~EdgeMDNSService() {}
+};
+
+/**
+ * EdgeData of EdgeWiFiService.
+ */
+typedef struct {
+  unsigned long reconnectDelay = ED_SERVICE_WIFI_RECONNECTDELAY;  /**< Initial delay of the reconnection */
+  unsigned long reconnectMax = ED_SERVICE_WIFI_RECONNECTMAX;      /**< Maximum delay of the reconnection */
+  unsigned long lost = 0;                                         /**< Time when the connection was lost */
+  unsigned long backoff = 0;                                      /**< Current delay of the reconnection */
+} EdgeWiFiService_t;
+
+/**
+ * EdgeWiFiService: A service driver that checks the WiFi connection and
+ * attempts to reconnect with the exponential backoff while the connection
+ * is lost. It is an alternative to the AutoConnectConfig::autoReconnect
+ * for the sketch that does not allow AutoConnect to block the loop.
+ */
+class EdgeWiFiService : public EdgeDriver<EdgeWiFiService_t> {
+ public:
+  EdgeWiFiService() {
+    _cbStart = [this]() { _start(); };
+    _cbProcess = [this]() { _process(); };
+    setPriority(ED_SERVICE_WIFI_PRIORITY);
+  }
+  ~EdgeWiFiService() {}
+
+ protected:
+  void  _start(void) {
+    data.lost = 0;
+    data.backoff = data.reconnectDelay;
+    setEdgeInterval(ED_SERVICE_WIFI_INTERVAL);
+  }
+
+  void  _process(void) {
+    if (WiFi.status() == WL_CONNECTED) {
+      data.lost = 0;
+      data.backoff = data.reconnectDelay;
+      return;
+    }
+
+    if (!data.lost)
+      data.lost = millis();
+    else if (millis() - data.lost >= data.backoff) {
+      ED_DBG("WiFi reconnecting\n");
+      WiFi.reconnect();
+      data.lost = millis();
+      data.backoff = std::min(data.backoff * 2, data.reconnectMax);
+    }
+  }
+};
+
+#endif // !_EDGESERVICES_H_
@@ -8,7 +8,142 @@
  */
 
 #include <algorithm>
+#include <cstdarg>
+#include <cstddef>
+#include <new>
 #include "EdgeUnified.h"
+#include "EdgeLogArgs.h"
+#if defined(ARDUINO_ARCH_ESP8266)
+#include <Ticker.h>
+#include <user_interface.h>
+#elif defined(ARDUINO_ARCH_ESP32)
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#if ESP_ARDUINO_VERSION_MAJOR < 3
+// The legacy RMT driver conflicts with the RMT driver of the Arduino core 3.
+#include <driver/rmt.h>
+#define ED_OFFLOAD_RMT
+#endif
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32) && ED_JOB_WORKER
+#define ED_JOB_WORKER_ENABLED
+#endif
+
+#if ED_TRACE_SIZE
+#define ED_TRACE(e, ev, id)   do { if (e) (e)->_trace.record(EdgeTrace::ev, id); } while (0)
+#else
+#define ED_TRACE(e, ev, id)   do {} while (0)
+#endif // !ED_TRACE_SIZE
+
+#if ED_BOOT_PHASES
+/**
+ * EdgeBootScope: Records a boot phase that lasts for the scope.
+ */
+class EdgeBootScope {
+ public:
+  EdgeBootScope(EdgeBoot* boot, PGM_P phase, const uint16_t id) : _boot(boot), _index(boot ? boot->begin(phase, id) : ED_BOOT_PHASES) {}
+  ~EdgeBootScope() { if (_boot) _boot->end(_index); }
+
+ protected:
+  EdgeBoot* _boot;                                      /**< Boot timeline */
+  size_t  _index;                                       /**< Index of the recorded phase */
+};
+
+#define ED_BOOT_PHASE(e, phase, id)   EdgeBootScope _edBootScope((e) ? &(e)->_boot : nullptr, PSTR(phase), id)
+#else
+#define ED_BOOT_PHASE(e, phase, id)   do {} while (0)
+#endif // !ED_BOOT_PHASES
+
+#if defined(ED_DEBUG) && ED_DEBUG_DEFERRED
+/**
+ * EdgeLog: Deferred backend of ED_DBG. The log function stores the address
+ * of the format string and the raw arguments into a slot of the lock-free
+ * ring buffer without formatting them, and the drain function writes out
+ * the records within the free space of the debug port from the tail of
+ * EdgeUnified::process. The string arguments are copied at the call, and
+ * the others are stored in 4 or 8 bytes according to the conversion
+ * specifications. A record that does not fit in the full ring is dropped
+ * and counted.
+ * It lives only in EdgeUnified.cpp, so its layout follows the macros that
+ * EdgeUnified.cpp was built with. The members are left to the
+ * zero-initialization of the static storage, so ED_DBG is available even
+ * in the constructors of the global objects.
+ */
+class EdgeLog {
+ public:
+  void  log(PGM_P fmt, va_list args);
+  size_t  drain(Print& out, const bool block = false);
+  uint32_t  dropped(void) const { return _drops; }
+
+ protected:
+  typedef struct {
+    std::atomic<uint32_t> seq;                          /**< Sequence of the slot, less its index */
+    PGM_P fmt;                                          /**< Format string */
+    uint32_t  tm;                                       /**< Time of the call [us] */
+    EdgeLogArgs<ED_DEBUG_ARGS_SIZE> args;               /**< Raw arguments */
+  } EdgeLogRecord_t;
+
+  EdgeLogRecord_t*  _reserve(uint32_t& pos);
+  void  _commit(EdgeLogRecord_t* rec, const uint32_t pos);
+  bool  _fetch(void);
+  size_t  _format(const EdgeLogRecord_t& rec);
+  size_t  _frame(const EdgeLogRecord_t& rec);
+
+  EdgeLogRecord_t _ring[ED_DEBUG_RING_SIZE];            /**< Deferred records */
+  std::atomic<uint32_t> _head;                          /**< Count of the reserved records */
+  uint32_t  _tail;                                      /**< Count of the drained records */
+  std::atomic<uint32_t> _drops;                         /**< Number of the dropped records */
+  uint32_t  _dropsReported;                             /**< Number of the drops already written out */
+  char  _line[ED_DEBUG_LINE_SIZE];                      /**< Record being written out */
+  size_t  _lineLen;                                     /**< Size of the record being written out */
+  size_t  _linePos;                                     /**< Size already written out */
+};
+
+// The deferred debug output is available regardless of NO_GLOBAL_INSTANCES
+// since ED_DBG refers to it.
+static EdgeLog  EdgeDebugLog;
+#endif
+
+static_assert(ED_DUTY_DRIVERS <= 32, "ED_DUTY_DRIVERS allows up to 32 EdgeDrivers");
+
+/**
+ * State of the duty cycle kept over the deep sleep. It is in the RTC slow
+ * memory on ESP32, and is copied from and to the RTC user memory on ESP8266.
+ */
+typedef struct {
+  uint32_t  magic;                                      /**< Validity of the state */
+  uint32_t  cycles;                                     /**< Number of the deep sleeps */
+  uint32_t  awake;                                      /**< Awake time [ms] of the last cycle */
+  uint32_t  awakeTotal;                                 /**< Total awake time [ms] of the cycles */
+  uint32_t  sleep;                                      /**< Duration [ms] of the last sleep */
+  uint32_t  drivers;                                    /**< Number of the valid schedules */
+  int32_t   due[ED_DUTY_DRIVERS];                       /**< Time [ms] until each EdgeDriver was due at the sleep */
+  uint32_t  digest;                                     /**< Digest of the above */
+} EdgeDutyState_t;
+
+#define ED_DUTY_MAGIC                         0xEDC0DE50UL
+
+#if defined(ARDUINO_ARCH_ESP32)
+RTC_DATA_ATTR static EdgeDutyState_t  _edgeDutyState;
+#else
+static EdgeDutyState_t  _edgeDutyState;
+#endif
+
+static uint32_t _edgeDutyDigest(void) {
+  EdgeHash  hash;
+  hash.write(reinterpret_cast<const uint8_t*>(&_edgeDutyState), offsetof(EdgeDutyState_t, digest));
+  return hash.value();
+}
+
+/**
+ * Ticks of the offload timers waiting for the loop, one bit for each slot.
+ * The timer callback only sets the bit of its slot, and never refers to
+ * the EdgeDriver which may have been destroyed when a late tick comes
+ * after the stop. The slots are taken and returned in the loop context.
+ */
+static std::atomic<uint32_t>  _edgeOffloadTicks(0);
+static uint32_t _edgeOffloadSlots = 0;
 
 /**
  * Specifies automatic restoration of EdgeData for EdgeDriver. Attaching
@@ -39,6 +174,16 @@ void EdgeDriverBase::autoSave(const bool onOff) {
     _persistance &= 0xf ^ (uint8_t)ED_PERSISTENT_AUTOSAVE;
 }
 
+/**
+ * Enables or disables the process callback of EdgeDriver. If the EdgeDriver
+ * owns AutoConnectAux pages, they are joined or released according to the
+ * change of the enable state.
+ * @param  onOff  Take either True or False, with True specifying enabling.
+ */
+void EdgeDriverBase::enable(const bool onOff) {
+  _setEnable(onOff);
+}
+
 /**
  * Call the end callback to terminate EdgeDriver. If auto-save is enabled
  * EdgeData is saved with the EdgeDriver<T>::save function.
@@ -47,37 +192,205 @@ void EdgeDriverBase::autoSave(const bool onOff) {
  * called again.
  */
 void EdgeDriverBase::end(void) {
-  if (_cbEnd)
+  _end(isAutoSave());
+}
+
+/**
+ * Call the end callback and deactivate the EdgeDriver.
+ * @param  flush  Saves EdgeData after the end callback.
+ */
+void EdgeDriverBase::_end(const bool flush) {
+  ED_TRACE(_edge, ED_TRACE_END, _traceId);
+  if (_cbEnd) {
+    ED_HEAP_ACCOUNT(_heap);
     _cbEnd();
+  }
 
-  if (isAutoSave())
+  if (flush)
     save();
-  _enable = false;
+  _setEnable(false);
+  _started = false;
+  if (_edge)
+    _edge->_gateChanged = true;
+}
+
+/**
+ * Ends the EdgeDriver from the destructor of the derived class, while the
+ * members that the end callback, the serializer and EdgeData refer to are
+ * alive. The callbacks are cleared and the autosave is turned off, so the
+ * end by ~EdgeDriverBase no longer reaches them.
+ */
+void EdgeDriverBase::_dispose(void) {
+  end();
+  autoSave(false);
+  _cbEnd = nullptr;
+  _cbFlush = nullptr;
+  _serializer = nullptr;
+  _deserializer = nullptr;
 }
 
 /**
  * Call the on-error callback to abort EdgeDriver processing. Once the error
  * callback is called, the EdgeDriver's process callback is disabled until the
- * start function is executed.
+ * start function is executed. The supervised EdgeDriver is restarted by
+ * EdgeUnified after the delay of the supervision policy.
  * @param  error  Error code. The value should be uniquely defined by the user
  * sketch according to the EdgeDriver properties. EdgeUnified is not involved
  * in the value and semantics of the error code.
  */
 void EdgeDriverBase::error(const int error) {
-  if (_cbError)
+  ED_TRACE(_edge, ED_TRACE_ERROR, _traceId);
+  _stats.errors++;
+  if (_cbError) {
+    ED_HEAP_ACCOUNT(_heap);
     _cbError(error);
-  _enable = false;
+  }
+  _setEnable(false);
+  _started = false;
+
+  if (_edge) {
+    _edge->_gateChanged = true;
+    if (_superviseDelay)
+      _edge->_failed(*this, error);
+  }
+}
+
+/**
+ * Declares that the hardware generates a waveform on the pin instead of the
+ * process toggling it. The waveform is generated by LEDC on ESP32, and by
+ * analogWrite on ESP8266 if the frequency is within its range, otherwise the
+ * pin is toggled by the timer when the duty is 50%. If no hardware can take
+ * over the waveform, the process callback remains as the software fallback.
+ * The offload runs while the EdgeDriver is enabled, it is started after the
+ * start callback and is stopped by the end, the error and disabling.
+ * @param  pin    GPIO pin of the waveform.
+ * @param  period Period [us] of the waveform.
+ * @param  duty   Duty [%] of the waveform.
+ */
+void EdgeDriverBase::offloadPWM(const uint8_t pin, const uint32_t period, const uint8_t duty) {
+  uint32_t  high = static_cast<uint64_t>(period) * std::min(duty, static_cast<uint8_t>(100)) / 100;
+  _offload(ED_OFFLOAD_PWM, pin, high, period - high);
+}
+
+/**
+ * Declares that the hardware generates a continuous pulse train on the pin
+ * instead of the process. The pulse train is generated by RMT on ESP32 with
+ * the Arduino core 2, otherwise it falls back to the same as offloadPWM.
+ * @param  pin  GPIO pin of the pulse train.
+ * @param  high High duration [us] of a pulse.
+ * @param  low  Low duration [us] of a pulse.
+ */
+void EdgeDriverBase::offloadPulse(const uint8_t pin, const uint32_t high, const uint32_t low) {
+  _offload(ED_OFFLOAD_PULSE, pin, high, low);
 }
 
 /**
  * Calls the process callback function when the EdgeDriver is in the enable
  * state. Also, if that EdgeDriver is periodic, it measures the period.
  * If the period has not reached the interval, the call to process callback
- * is abandoned.
+ * is abandoned. The EdgeDriver offloaded to the hardware is not called,
+ * except at the tick of the offload timer.
+ * The duration of the call is accumulated to the statistics, and the call
+ * exceeding the budget is an overrun that the watchdog deals with.
  */
 void EdgeDriverBase::process(void) {
-  if (_enable && _cbProcess && _elapse())
-    _cbProcess();
+  if (_enable && _cbProcess && (_offloaded ? _offloadTicked() : _elapse())) {
+    ED_TRACE(_edge, ED_TRACE_PROCESS_BEGIN, _traceId);
+    unsigned long tm = micros();
+    {
+      ED_HEAP_ACCOUNT(_heap);
+      _cbProcess();
+    }
+    uint32_t  elapsed = micros() - tm;
+    ED_TRACE(_edge, ED_TRACE_PROCESS_END, _traceId);
+
+    _stats.processes++;
+    _stats.processTime += elapsed;
+    _stats.processMax = std::max(_stats.processMax, elapsed);
+    if (_budget) {
+      if (elapsed > _budget)
+        _overrun(elapsed);
+      else
+        _overrunStreak = 0;
+    }
+  }
+}
+
+/**
+ * Schedules the next EdgeDriver::process call as a retry of the failed
+ * operation with the exponential backoff. The delay doubles with each
+ * consecutive retry up to the maximum delay of the retry policy, and a
+ * random jitter of up to half the delay is subtracted so that the devices
+ * failed at the same time do not retry in lockstep. Until the retry
+ * succeeds, EdgeUnified::process calls the process callback only after
+ * the delay has passed instead of the interval. The driver calls succeeded
+ * to return to the interval.
+ * @return true   The retry has been scheduled.
+ * @return false  The retries reached the maximum attempts of the policy. The
+ * retry is abandoned and the process returns to the interval.
+ */
+bool EdgeDriverBase::retryLater(void) {
+  if (_retryAttempts && _retries >= _retryAttempts) {
+    ED_DBG("%s retries exceeded\n", getTypeName().c_str());
+    succeeded();
+    return false;
+  }
+
+  unsigned long delay = _retryDelay;
+  for (uint8_t n = 0; n < _retries && delay < _retryMaxDelay; n++)
+    delay <<= 1;
+  delay = std::min(delay, _retryMaxDelay);
+  _retryTm = delay - static_cast<unsigned long>(random(static_cast<long>(delay / 2) + 1));
+  if (_retries < UINT8_MAX)
+    _retries++;
+  _tm = millis();
+  return true;
+}
+
+/**
+ * Sets the retry policy for the retryLater.
+ * @param  delay    Initial delay [ms] of the retry.
+ * @param  maxDelay Maximum delay [ms] of the retry.
+ * @param  attempts Maximum number of the retry attempts. Zero means that
+ * the retry continues until it succeeds.
+ */
+void EdgeDriverBase::retryPolicy(const unsigned long delay, const unsigned long maxDelay, const uint8_t attempts) {
+  _retryDelay = delay;
+  _retryMaxDelay = maxDelay;
+  _retryAttempts = attempts;
+}
+
+/**
+ * Sets the slack of the EdgeDriver::process period. EdgeUnified opens a
+ * wake slot when the earliest EdgeDriver reaches the end of its slack, and
+ * runs all the EdgeDrivers within their slack of the period back to back
+ * in that slot. The EdgeDriver::process runs up to the slack earlier or
+ * later than the period, and the scattered wakeups of the EdgeDrivers with
+ * the unrelated intervals are coalesced into the fewer slots.
+ * @param  slack  Tolerance [ms] of the period. Zero runs the process at the
+ * period exactly as without the coalescing.
+ */
+void EdgeDriverBase::setEdgeSlack(const unsigned long slack) {
+  _slack = slack;
+  if (static_cast<long>(millis() - _tm) < 0)
+    _tm = millis();
+  if (_edge && slack)
+    _edge->_coalesce = true;
+}
+
+/**
+ * Sets the priority of EdgeDriver. EdgeUnified::process calls the process
+ * of EdgeDrivers in descending order of the priority, and the order of the
+ * EdgeDrivers with the same priority is the order in which they attached.
+ * The attached EdgeDriver takes the new order after the current turn of the
+ * process, so that it can be called from within the process.
+ * @param  priority Priority of the EdgeDriver. The default is
+ * ED_PRIORITY_DEFAULT.
+ */
+void EdgeDriverBase::setPriority(const uint8_t priority) {
+  _priority = priority;
+  if (_edge)
+    _edge->_reorder = true;
 }
 
 /**
@@ -88,7 +401,22 @@ void EdgeDriverBase::process(void) {
  * interval is not changed.
  */
 void EdgeDriverBase::start(const long interval) {
+  ED_TRACE(_edge, ED_TRACE_START, _traceId);
   _enable = true;
+  _started = true;
+  _gated = false;
+  _restartPending = false;
+  succeeded();
+
+  // Restarting lifts the demotion by the watchdog
+  _overrunStreak = 0;
+  if (_demotions) {
+    _demotions = 0;
+    _priority = _basePriority;
+    setEdgeInterval(_baseInterval);
+    if (_edge)
+      _edge->_reorder = true;
+  }
 
   if (isAutoRestore())
     restore();
@@ -96,8 +424,19 @@ void EdgeDriverBase::start(const long interval) {
   if (interval >= 0)
     setEdgeInterval(interval);
 
-  if (_cbStart)
+  if (_cbStart) {
+    ED_BOOT_PHASE(_edge, "start", _traceId);
+    ED_HEAP_ACCOUNT(_heap);
     _cbStart();
+  }
+
+  if (_offloadType != ED_OFFLOAD_NONE)
+    _offloadStart();
+
+  if (_edge) {
+    _edge->_gateChanged = true;
+    _edge->_bindPages(*this);
+  }
 }
 
 /**
@@ -111,6 +450,8 @@ void EdgeDriverBase::start(const long interval) {
  * @return The size of the restored EdgeData. If it is zero, the restore failed.
  */
 size_t EdgeDriverBase::restore(AUTOCONNECT_APPLIED_FILECLASS& fs, const char* fileName) {
+  ED_BOOT_PHASE(_edge, "restore", _traceId);
+  ED_HEAP_ACCOUNT(_heap);
   String  fn = String(fileName);
   size_t  size = 0;
 
@@ -120,6 +461,8 @@ size_t EdgeDriverBase::restore(AUTOCONNECT_APPLIED_FILECLASS& fs, const char* fi
   else if (fn[0] != '/')
     fn = '/' + fn;
 
+  ED_TRACE(_edge, ED_TRACE_RESTORE, _traceId);
+  unsigned long tm = micros();
   File  inFile = fs.open(fn.c_str(), "r");
   ED_DBG("Restore EdgeData %s ", fn.c_str());
 
@@ -151,6 +494,13 @@ size_t EdgeDriverBase::restore(AUTOCONNECT_APPLIED_FILECLASS& fs, const char* fi
   else
     ED_DBG_DUMB("open failed\n");
 
+  // The digest tells whether EdgeData has changed since then
+  if (size)
+    _savedDigest = _digest();
+
+  _stats.restores++;
+  _stats.restoreBytes += size;
+  _stats.restoreTime += micros() - tm;
   return size;
 }
 
@@ -165,6 +515,7 @@ size_t EdgeDriverBase::restore(AUTOCONNECT_APPLIED_FILECLASS& fs, const char* fi
  * @return The size of the saving EdgeData. If it is zero, the save failed.
  */
 size_t EdgeDriverBase::save(AUTOCONNECT_APPLIED_FILECLASS& fs, const char* fileName) {
+  ED_HEAP_ACCOUNT(_heap);
   String  fn = String(fileName);
   size_t  size = 0;
 
@@ -174,6 +525,8 @@ size_t EdgeDriverBase::save(AUTOCONNECT_APPLIED_FILECLASS& fs, const char* fileN
   else if (fn[0] != '/')
     fn = '/' + fn;
 
+  ED_TRACE(_edge, ED_TRACE_SAVE, _traceId);
+  unsigned long tm = micros();
   File  outFile = fs.open(fn.c_str(), "w");
   ED_DBG("Save EdgeData %s ", fn.c_str());
 
@@ -193,6 +546,12 @@ size_t EdgeDriverBase::save(AUTOCONNECT_APPLIED_FILECLASS& fs, const char* fileN
   else
     ED_DBG_DUMB("open failed\n");
 
+  if (size)
+    _savedDigest = _digest();
+
+  _stats.saves++;
+  _stats.saveBytes += size;
+  _stats.saveTime += micros() - tm;
   return size;
 }
 
@@ -202,6 +561,68 @@ void EdgeDriverBase::serializer(EdgeDataSerializerT serializer, EdgeDataSerializ
   _jsonBufferSize = bufferSize;
 }
 
+/**
+ * Enables the telemetry of EdgeData pushed to the Server-Sent Events
+ * connections by EdgeUnified::events. EdgeUnified pushes only the fields
+ * whose values have changed since the last push.
+ * @param  reporter Serializer that outputs the fields to be pushed. If it is
+ * nullptr, all fields output by the EdgeData serializer are pushed.
+ */
+void EdgeDriverBase::telemetry(EdgeDataSerializerT reporter) {
+  _reporter = reporter;
+  _telemetry = true;
+  _telemetryHash.clear();
+}
+
+/**
+ * Sets the supervision policy with which EdgeUnified restarts the EdgeDriver
+ * stopped by the error. The restart is delayed by the exponential backoff
+ * that doubles with each failure within the window, up to the maximum
+ * delay. If the failures within the window reach the limit, EdgeUnified
+ * gives up the restart and calls the escalation handler instead. The
+ * EdgeDrivers registered with restartWith are ended before the restart and
+ * started after it.
+ * @param  delay    Initial delay [ms] of the restart. Zero stops the
+ * supervision.
+ * @param  maxDelay Maximum delay [ms] of the restart.
+ * @param  failures Number of the failures within the window to escalate.
+ * Zero means that the restart continues forever.
+ * @param  window   Period [ms] in which the failures are counted. The count
+ * is cleared when the window has passed since its first failure.
+ */
+void EdgeDriverBase::supervise(const unsigned long delay, const unsigned long maxDelay, const uint8_t failures, const unsigned long window) {
+  _superviseDelay = delay;
+  _superviseMaxDelay = std::max(delay, maxDelay);
+  _superviseFailures = failures;
+  _superviseWindow = window;
+  _failures = 0;
+  if (!delay)
+    _restartPending = false;
+}
+
+/**
+ * Demotes the EdgeDriver overrunning its budget. The priority is halved and
+ * the interval is doubled up to ED_WATCHDOG_MAXINTERVAL, or the EdgeDriver
+ * without the interval is given ED_WATCHDOG_INTERVAL. EdgeUnified sorts the
+ * EdgeDrivers by the demoted priority after the current turn of the process.
+ * The original priority and interval return when the EdgeDriver starts
+ * again.
+ */
+void EdgeDriverBase::_demote(void) {
+  if (!_demotions) {
+    _basePriority = _priority;
+    _baseInterval = _interval;
+  }
+  if (_demotions < UINT8_MAX)
+    _demotions++;
+  _priority >>= 1;
+  unsigned long interval = _interval ? _interval << 1 : ED_WATCHDOG_INTERVAL;
+  setEdgeInterval(std::max(_interval, std::min(interval, static_cast<unsigned long>(ED_WATCHDOG_MAXINTERVAL))));
+  if (_edge)
+    _edge->_reorder = true;
+  ED_DBG("%s demoted, priority %u interval %lu\n", getTypeName().c_str(), _priority, _interval);
+}
+
 /**
  * Constrains the execution of the relevant EdgeDriver by cycle.
  * EdgeDriverBase::setEdgeInterval function allows the EdgeDriver::process
@@ -213,11 +634,30 @@ void EdgeDriverBase::serializer(EdgeDataSerializerT serializer, EdgeDataSerializ
  * EdgeDriver inadvertently waits or forms a loop with a while; delay, it will
  * affect the event handling of other EdgeDrivers. In particular, WebServer
  * and AutoConnect will not be able to respond to TCP requests.
+ * While a retry is pending by retryLater, the period is the retry delay.
+ * The EdgeDriver with the slack runs within the slack of the period only
+ * while EdgeUnified has opened the wake slot.
  * @return true   The end of the period was reached.
  * @return false  The end of the period has not been reached.
  */
 bool EdgeDriverBase::_elapse(void) {
-  if (millis() - _tm > _interval) {
+  const unsigned long period = _retries ? _retryTm : _interval;
+  if (_slack && period && _edge) {
+    // Within the slack, the period keeps its phase so that running early
+    // or late does not drift the rate, then _tm may be ahead of the time.
+    const long  elapsed = static_cast<long>(millis() - _tm);
+    const long  span = static_cast<long>(period);
+    const long  slack = static_cast<long>(_slack);
+    if (_edge->_slot ? elapsed + slack <= span : elapsed <= span + slack)
+      return false;
+    if (elapsed <= span + 1 + slack)
+      _tm += period + 1;
+    else
+      _tm = millis();
+    return true;
+  }
+
+  if (millis() - _tm > period) {
     _tm = millis();
     return true;
   }
@@ -236,187 +676,1126 @@ void EdgeDriverBase::_embedType(const String& pf) {
 }
 
 /**
- * Attach EdgeDriver to EdgeUnified. The attached EdgeDriver is integrated
- * into the event loop formed by the EdgeUnified, and EdgeDriver::process
- * is called as an extension of the EdgeUnified::process function call.
- * The EdgeData is also restored from the file system by the attach function
- * when that EdgeDriver is in the EdgeDriver::autoRestore enabled state.
- * @param  driver   EdgeDriver instance to be integrated into EdgeUnified.
- * @param  interval Specifies the period interval at which the EdgeDriver::
- * process is allowed to run. If a negative value is specified, the current
- * interval is not changed.
+ * Replaces the declared offload. If the EdgeDriver is running, the current
+ * offload is stopped and the new one is started immediately.
  */
-void EdgeUnified::attach(EdgeDriverBase& driver, const long interval) {
-  ED_DBG("Attaching driver...");
-  _drivers.push_back(driver);
-  ED_DBG_DUMB("%s\n", driver.getTypeName().c_str());
-  driver.start(interval);
+void EdgeDriverBase::_offload(const OFFLOAD_t type, const uint8_t pin, const uint32_t high, const uint32_t low) {
+  _offloadStop();
+  _offloadType = type;
+  _offloadPin = pin;
+  _offloadHigh = high;
+  _offloadLow = low;
+  if (_enable && _edge && type != ED_OFFLOAD_NONE)
+    _offloadStart();
 }
 
 /**
- * Consolidate multiple EdgeDrivers into EdgeUnified at once.
- * @param  drivers  Array of EdgeDriver instances to be integrated
- * into EdgeUnified.
+ * Configures the hardware for the declared offload. The waveform that the
+ * hardware cannot generate falls back to the timer toggling the pin, and
+ * the offload that no hardware can take over falls back to the process.
+ * @return true   The hardware has taken over the process.
+ * @return false  The EdgeDriver remains polled by EdgeUnified::process.
  */
-void EdgeUnified::attach(std::vector<std::reference_wrapper<EdgeDriverBase>> drivers) {
-  for (EdgeDriverBase& driver : drivers) {
-    attach(driver);
+bool EdgeDriverBase::_offloadStart(void) {
+  if (_offloaded)
+    return true;
+
+  uint32_t  period = _offloadHigh + _offloadLow;
+  bool  toggle = false;
+
+  // The pin returns to the current level when the offload stops.
+  if (_offloadType != ED_OFFLOAD_TIMER)
+    _offloadIdle = digitalRead(_offloadPin);
+
+  switch (_offloadType) {
+  case ED_OFFLOAD_PULSE:
+#ifdef ED_OFFLOAD_RMT
+    if (_offloadHigh && _offloadHigh < 0x8000 && _offloadLow && _offloadLow < 0x8000) {
+      static int8_t rmtChannels = 0;
+      if (_offloadChannel < 0 && rmtChannels < SOC_RMT_TX_CANDIDATES_PER_GROUP)
+        _offloadChannel = rmtChannels++;
+      if (_offloadChannel >= 0) {
+        rmt_config_t  config = RMT_DEFAULT_CONFIG_TX(static_cast<gpio_num_t>(_offloadPin), static_cast<rmt_channel_t>(_offloadChannel));
+        config.clk_div = 80;  // 1 us tick
+        config.tx_config.loop_en = true;
+        rmt_item32_t  item;
+        item.level0 = 1;
+        item.duration0 = _offloadHigh;
+        item.level1 = 0;
+        item.duration1 = _offloadLow;
+        if (rmt_config(&config) == ESP_OK && rmt_driver_install(config.channel, 0, 0) == ESP_OK) {
+          _offloaded = rmt_write_items(config.channel, &item, 1, false) == ESP_OK;
+          if (!_offloaded)
+            rmt_driver_uninstall(config.channel);
+        }
+      }
+      break;
+    }
+    // The durations RMT cannot represent are generated by LEDC.
+#endif
+    // fall through
+  case ED_OFFLOAD_PWM:
+    if (!period || !_offloadHigh || !_offloadLow) {
+      // A flat waveform needs no hardware.
+      pinMode(_offloadPin, OUTPUT);
+      digitalWrite(_offloadPin, _offloadHigh ? HIGH : LOW);
+      _offloaded = period > 0;
+      break;
+    }
+    toggle = _offloadHigh == _offloadLow;
+#if defined(ARDUINO_ARCH_ESP32)
+    if (period <= 1000000) {
+      uint32_t  freq = 1000000 / period;
+      uint32_t  duty = (static_cast<uint64_t>(_offloadHigh) << ED_OFFLOAD_LEDC_RESOLUTION) / period;
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+      if (ledcAttach(_offloadPin, freq, ED_OFFLOAD_LEDC_RESOLUTION))
+        _offloaded = ledcWrite(_offloadPin, duty);
+#else
+      static int8_t ledcChannels = 0;
+      if (_offloadChannel < 0 && ledcChannels < SOC_LEDC_CHANNEL_NUM)
+        _offloadChannel = ledcChannels++;
+      if (_offloadChannel >= 0 && ledcSetup(_offloadChannel, freq, ED_OFFLOAD_LEDC_RESOLUTION)) {
+        ledcAttachPin(_offloadPin, _offloadChannel);
+        ledcWrite(_offloadChannel, duty);
+        _offloaded = true;
+      }
+#endif
+    }
+#elif defined(ARDUINO_ARCH_ESP8266)
+    if (period >= 25 && period <= 10000) {
+      // analogWrite covers 100 Hz to 40 kHz with the frequency shared by all
+      // the pins.
+      analogWriteRange(255);
+      analogWriteFreq(1000000 / period);
+      analogWrite(_offloadPin, _offloadHigh * 255 / period);
+      _offloaded = true;
+    }
+#endif
+    if (_offloaded || !toggle)
+      break;
+    period = _offloadHigh;
+    // fall through
+  case ED_OFFLOAD_TIMER:
+    if (!period)
+      break;
+    if (_offloadType == ED_OFFLOAD_TIMER) {
+      // The timer only ticks, and the process runs in the loop at the next
+      // turn of EdgeUnified::process. It keeps the callback of the sketch
+      // out of the timer task or the system context, where it would race
+      // the loop without the lock.
+      if (!~_edgeOffloadSlots)
+        break;
+      while (_edgeOffloadSlots & (1UL << ++_offloadTick))
+        ;
+      _edgeOffloadSlots |= 1UL << _offloadTick;
+      _edgeOffloadTicks.fetch_and(~(1UL << _offloadTick));
+    }
+#if defined(ARDUINO_ARCH_ESP32)
+    {
+      // Neither callback refers to the EdgeDriver, since esp_timer_stop
+      // does not wait for the callback already dispatched.
+      esp_timer_create_args_t args = {};
+      if (_offloadType == ED_OFFLOAD_TIMER) {
+        args.callback = [](void* arg) {
+          _edgeOffloadTicks.fetch_or(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(arg)));
+        };
+        args.arg = reinterpret_cast<void*>(static_cast<uintptr_t>(1UL << _offloadTick));
+      }
+      else {
+        args.callback = [](void* arg) {
+          const uint8_t pin = static_cast<uint8_t>(reinterpret_cast<uintptr_t>(arg));
+          digitalWrite(pin, !digitalRead(pin));
+        };
+        args.arg = reinterpret_cast<void*>(static_cast<uintptr_t>(_offloadPin));
+      }
+      args.dispatch_method = ESP_TIMER_TASK;
+      args.name = "EdgeDriver";
+      esp_timer_handle_t  timer;
+      if (esp_timer_create(&args, &timer) == ESP_OK) {
+        if (esp_timer_start_periodic(timer, period) == ESP_OK) {
+          _offloadHandle = timer;
+          _offloaded = true;
+        }
+        else
+          esp_timer_delete(timer);
+      }
+    }
+#elif defined(ARDUINO_ARCH_ESP8266)
+    if (period >= 1000) {
+      // The Ticker callback runs in the system context. The pin toggle
+      // completes there, and the tick is taken by the loop.
+      Ticker* ticker = new Ticker();
+      if (_offloadType == ED_OFFLOAD_TIMER)
+        ticker->attach_ms<uint32_t>(period / 1000, [](uint32_t tick) { _edgeOffloadTicks.fetch_or(tick); }, static_cast<uint32_t>(1UL << _offloadTick));
+      else
+        ticker->attach_ms(period / 1000, [this]() { digitalWrite(_offloadPin, !digitalRead(_offloadPin)); });
+      _offloadHandle = ticker;
+      _offloaded = true;
+    }
+#endif
+    if (!_offloaded && _offloadTick >= 0) {
+      _edgeOffloadSlots &= ~(1UL << _offloadTick);
+      _offloadTick = -1;
+    }
+    break;
+  default:
+    break;
   }
+
+  if (_offloadType == ED_OFFLOAD_TIMER && !_cbProcess)
+    _offloadStop();
+  ED_DBG("%s offload %d:%s\n", getTypeName().c_str(), static_cast<int>(_offloadType), _offloaded ? "hardware" : "software");
+  return _offloaded;
 }
 
 /**
- * Detach a EdgeDriver from EdgeUnified. Also it calls EdgeDriver's end
- * callback upon detachment.
- * @param  driver EdgeDriver instance to be detached from EdgeUnified.
+ * Tears down the hardware offload and returns the EdgeDriver to the polling
+ * of EdgeUnified::process.
  */
-void EdgeUnified::detach(const EdgeDriverBase& driver) {
-  _drivers.erase(std::remove_if(_drivers.begin(), _drivers.end(), [&](const EdgeDriverBase& _driver) {
-    return std::addressof(driver) == std::addressof(_driver);
-  }), _drivers.end());
+void EdgeDriverBase::_offloadStop(void) {
+  if (!_offloaded)
+    return;
+
+  if (_offloadHandle) {
+#if defined(ARDUINO_ARCH_ESP32)
+    esp_timer_handle_t  timer = static_cast<esp_timer_handle_t>(_offloadHandle);
+    esp_timer_stop(timer);
+    esp_timer_delete(timer);
+#elif defined(ARDUINO_ARCH_ESP8266)
+    delete static_cast<Ticker*>(_offloadHandle);
+#endif
+    _offloadHandle = nullptr;
+    if (_offloadTick >= 0) {
+      _edgeOffloadSlots &= ~(1UL << _offloadTick);
+      _offloadTick = -1;
+    }
+  }
+  else if (_offloadHigh && _offloadLow) {
+#ifdef ED_OFFLOAD_RMT
+    if (_offloadType == ED_OFFLOAD_PULSE && _offloadHigh < 0x8000 && _offloadLow < 0x8000) {
+      rmt_tx_stop(static_cast<rmt_channel_t>(_offloadChannel));
+      rmt_driver_uninstall(static_cast<rmt_channel_t>(_offloadChannel));
+    }
+    else
+#endif
+    {
+#if defined(ARDUINO_ARCH_ESP32)
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+      ledcDetach(_offloadPin);
+#else
+      ledcDetachPin(_offloadPin);
+#endif
+#endif
+    }
+  }
+  if (_offloadType != ED_OFFLOAD_TIMER) {
+    // Routes the pin from the peripheral back to the GPIO.
+    pinMode(_offloadPin, OUTPUT);
+    digitalWrite(_offloadPin, _offloadIdle);
+  }
+  _offloaded = false;
 }
 
 /**
- * Pair the JSON description of the AutoConnectAux custom web page with the
- * request handler and bind it to EdgeUnified. If EdgeUnified does not own
- * the AutoConnect instance at the time of binding (i.e. AutoConnect::begin
- * has not run), EdgeUnified will delay loading the AutoConnectAux JSON.
- * @param  json       Pointer to JSON description of the AutoConnectAux.
- * @param  auxHandler AutoConnectAux request handler.
+ * Takes the tick of the offload timer that came since the last call.
+ * @return true   The offload timer has ticked.
  */
-void EdgeUnified::join(PGM_P json, AuxHandlerFunctionT auxHandler) {
-  EdgeAux aux(json, auxHandler);
-  join({ aux });
+bool EdgeDriverBase::_offloadTicked(void) {
+  if (_offloadTick < 0)
+    return false;
+  const uint32_t  tick = 1UL << _offloadTick;
+  return _edgeOffloadTicks.fetch_and(~tick) & tick;
 }
 
 /**
- * Pair the JSON description of the AutoConnectAux custom web page with the
- * request handler and bind it to EdgeUnified. If EdgeUnified does not own
- * the AutoConnect instance at the time of binding (i.e. AutoConnect::begin
- * has not run), EdgeUnified will delay loading the AutoConnectAux JSON.
- * @param  json       __FlashStringHelper pointer through PROGMEM area. When
- * the PROGMEM attribute is given to the JSON description and placed in the
- * flash area, the JSON description is passed through the FPSTR macro.
- * @param  auxHandler AutoConnectAux request handler.
+ * Watchdog of the process call that exceeded the budget. The consecutive
+ * overruns demote the EdgeDriver every demote threshold, and stop it with
+ * ED_ERROR_OVERRUN when they reach the limit. The watchdog acts after the
+ * call returns, so it does not rescue the loop from a call that blocks for
+ * longer than the hardware watchdog allows.
+ * @param  elapsed  Duration [us] of the process call.
  */
-void EdgeUnified::join(const __FlashStringHelper* json, AuxHandlerFunctionT auxHandler) {
-  EdgeAux aux(json, auxHandler);
-  join({ aux });
+void EdgeDriverBase::_overrun(const uint32_t elapsed) {
+  _stats.overruns++;
+  if (_overrunStreak < UINT8_MAX)
+    _overrunStreak++;
+  ED_DBG("%s overrun %lu us, budget %lu us\n", getTypeName().c_str(), static_cast<unsigned long>(elapsed), _budget);
+
+  if (_watchdogLimit && _overrunStreak >= _watchdogLimit) {
+    ED_DBG("%s stopped by the watchdog\n", getTypeName().c_str());
+    _overrunStreak = 0;
+    error(ED_ERROR_OVERRUN);
+  }
+  else if (_watchdogDemote && !(_overrunStreak % _watchdogDemote))
+    _demote();
 }
 
 /**
- * Combines multiple JSON description of the AutoConnectAux custom web page
- * and the request handler pairs into EdgeUnified at once.
- * If page specifier has the `FILE:` identifier, the join try to load JSON
- * from the file.
- * @param  pages  Array of JSON and the request handler pairs.
+ * Calculates the digest of EdgeData in the same form as it is saved.
+ * @return FNV-1a hash of the serialized EdgeData.
  */
-void EdgeUnified::join(const std::vector<EdgeAux>& pages) {
-  for (const EdgeAux& page : pages) {
-    if (!page.json && !page.json_p) {
-      ED_DBG("AutoConnectAux JSON descriptor missing\n");
-      continue;
-    }
-
-    // Determines the input source of the JSON description.
-    // If `PGM_P json` has a File: identifier as prefix, then a JSON description
-    // file is loaded from the stream originating from its opened.
-    File  jsonFile;
-    if (page.json) {
-      const char* jsonIn = page.json;
-      const char* jsonProtocol = ED_AUXJSONPROTOCOL_FILE;
-      int diff = 0;
-      while (!diff && *jsonProtocol)
-        diff = tolower((int)*jsonIn++) - (int)*jsonProtocol++;
-      if (!diff) {
-        jsonFile = AUTOCONNECT_APPLIED_FILESYSTEM.open(jsonIn, "r");
-        if (!jsonFile.available()) {
-          ED_DBG("join %s open failed or empty\n", page.json);
-          continue;
-        }
-      }
-    }
+uint32_t EdgeDriverBase::_digest(void) {
+  EdgeHash  hash;
+  if (_serializer) {
+    ArduinoJsonBuffer doc(_jsonBufferSize);
+    ArduinoJsonObject json = ARDUINOJSON_CREATEOBJECT(doc);
+    _serializer(json);
+    ArduinoJson::serializeJson(json, hash);
+  }
+  else
+    _dataDigest(hash);
+  return hash.value();
+}
 
-    AutoConnectAux* aux = new AutoConnectAux;
-    if (aux) {
-      // Loading AutoConnectAux JSON description
-      bool  ldcc = false;
-      if (jsonFile)
-        ldcc = aux->load(jsonFile);
-      else if (page.json)
-        ldcc = aux->load(page.json);
-      else if (page.json_p)
-        ldcc = aux->load(page.json_p);
-      if (ldcc) {
-        if (page.auxHandler) {
-          aux->on(page.auxHandler);
-          if (_portal) {
-            AutoConnectAux* hasLoaded = _portal->aux(aux->uri());
-            if (hasLoaded) {
-              _portal->detach(hasLoaded->uri());
-              delete hasLoaded;
-            }
-            _portal->join(*aux);
-          }
-          else {
-            _auxQueue.push_back(aux);
-            ED_DBG("%s has entered _auxQueue.\n", aux->uri());
-          }
-        }
-      }
-      else
-        // JSON deserialize error, ignore AutoCOnnectAux
-        delete aux;
-    }
-    else {
-      ED_DBG("New AutoConnectAux allocation failed\n");
-    }
+/**
+ * Calculates the time until the end of the period.
+ * @param  now  Current time [ms].
+ * @return The time [ms] until the process becomes due, it is zero or
+ * negative if already due.
+ */
+long EdgeDriverBase::_remain(const unsigned long now) const {
+  const unsigned long period = _retries ? _retryTm : _interval;
+  return static_cast<long>(period - (now - _tm)) + 1;
+}
 
-    // Delete instances in `file:` of `PGM_P json` file.
-    if (jsonFile)
-      jsonFile.close();
-  }
+/**
+ * Determines whether the EdgeDriver is polled every turn of the process
+ * without the interval, which keeps the loop from sleeping.
+ * @return true   The EdgeDriver runs every turn.
+ */
+bool EdgeDriverBase::_busy(void) const {
+  return _enable && !_offloaded && _cbProcess && !(_retries ? _retryTm : _interval);
 }
 
 /**
- * Calls the on-error callback of all EdgeDrivers bound to EdgeUnified to abort
- * processing. Once the error callback is called, the EdgeDriver's process
- * callback is disabled until the EdgeDriver::start function is executed.
- * @param  error  Error code. The value should be uniquely defined by the user
- * sketch according to the EdgeDriver properties. EdgeUnified is not involved
- * in the value and semantics of the error code.
+ * Determines whether all the prerequisites of the EdgeDriver hold.
+ * @return true   The EdgeDriver is ready to start.
  */
-void EdgeUnified::abort(const int error) {
-  for (EdgeDriverBase& driver : _drivers)
-    driver.error(error);
+bool EdgeDriverBase::_ready(void) const {
+  for (const EdgeRequire& require : _requires)
+    if (!require.holds())
+      return false;
+  return true;
 }
 
 /**
- * Calls the end callback of all EdgeDrivers bound to EdgeUnified to end
- * processing.
+ * Changes the enable state of EdgeDriver and notifies the change to the
+ * EdgeUnified to which the EdgeDriver is attached. The hardware offload
+ * follows the enable state.
+ * @param  onOff  Take either True or False, with True specifying enabling.
  */
-void EdgeUnified::end(void) {
-  for (EdgeDriverBase& driver : _drivers)
-    driver.end();
+void EdgeDriverBase::_setEnable(const bool onOff) {
+  if (_enable != onOff) {
+    _enable = onOff;
+    if (_offloadType != ED_OFFLOAD_NONE) {
+      if (onOff)
+        _offloadStart();
+      else
+        _offloadStop();
+    }
+    if (_edge)
+      _edge->_bindPages(*this);
+  }
 }
 
+#if ED_TRACE_SIZE
+static_assert(!(ED_TRACE_SIZE & (ED_TRACE_SIZE - 1)), "ED_TRACE_SIZE must be a power of 2");
+
 /**
- * Loads the JSON custom web page descriptions which have not yet loaded into
- * AutoConnect among those bound to EdgeUnified.
- * @param  portal A reference to the AutoConnect instance.
+ * Records the event. The ring is allocated at the first record.
+ * @param  event  Lifecycle event.
+ * @param  id     Trace id of the EdgeDriver, 0 is EdgeUnified.
  */
-void EdgeUnified::portal(AutoConnect& portal) {
-  if (!_portal)
-    _portal = &portal;
-  
-  if (_auxQueue.size()) {
-    for (AutoConnectAux* aux : _auxQueue)
-      _portal->join(*aux);
-    _auxQueue.clear();
+void EdgeTrace::record(const EdgeTraceEvent_t event, const uint16_t id) {
+  if (!_ring)
+    _ring = new(std::nothrow) EdgeTraceEntry_t[ED_TRACE_SIZE];
+  if (_enable && _ring) {
+    EdgeTraceEntry_t& entry = _ring[_head++ & (ED_TRACE_SIZE - 1)];
+    entry.tm = micros();
+    entry.id = id;
+    entry.event = event;
   }
 }
 
 /**
- * Consecutively calls the process function of the EdgeDrivers bound to the
+ * Outputs the recorded events in the Chrome trace JSON format. Recording
+ * pauses during the output so the events are not overwritten. The
+ * timestamps are continued over the wraparound of micros.
+ * @param  out    Output destination.
+ * @param  nameOf Function that gives the track name of the trace id.
+ * @return The size of the output.
+ */
+size_t EdgeTrace::dump(Print& out, std::function<String(uint16_t)> nameOf) {
+  static const char* const  eventName[] = {
+    "attach", "start", "process", "process", "end", "error", "save", "restore", "join", "release"
+  };
+  const bool  enable = _enable;
+  _enable = false;
+
+  const uint32_t  count = std::min(_head, static_cast<uint32_t>(ED_TRACE_SIZE));
+  std::vector<uint16_t> ids;
+  uint32_t  sec = 0;
+  uint32_t  usec = 0;
+  uint32_t  prev = 0;
+  size_t  size = out.print(F("{\"traceEvents\":["));
+
+  for (uint32_t n = _head - count; n != _head; n++) {
+    const EdgeTraceEntry_t& entry = _ring[n & (ED_TRACE_SIZE - 1)];
+    if (n != _head - count) {
+      usec += entry.tm - prev;
+      sec += usec / 1000000;
+      usec %= 1000000;
+    }
+    prev = entry.tm;
+    if (std::find(ids.begin(), ids.end(), entry.id) == ids.end())
+      ids.push_back(entry.id);
+
+    const char  ph = entry.event == ED_TRACE_PROCESS_BEGIN ? 'B' : (entry.event == ED_TRACE_PROCESS_END ? 'E' : 'i');
+    if (n != _head - count)
+      size += out.print(',');
+    size += out.printf_P(PSTR("{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":"), eventName[entry.event], ph, entry.id);
+    if (sec)
+      size += out.printf_P(PSTR("%lu%06lu"), static_cast<unsigned long>(sec), static_cast<unsigned long>(usec));
+    else
+      size += out.print(usec);
+    if (ph == 'i')
+      size += out.print(F(",\"s\":\"t\""));
+    size += out.print('}');
+  }
+
+  // Names the track of each EdgeDriver with the type of its EdgeData.
+  for (uint16_t id : ids) {
+    if (count)
+      size += out.print(',');
+    size += out.printf_P(PSTR("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}"), id, nameOf(id).c_str());
+  }
+  size += out.print(F("]}"));
+
+  _enable = enable;
+  return size;
+}
+#endif // !ED_TRACE_SIZE
+
+static_assert(ED_AUXPOOL_BLOCKS <= 32, "ED_AUXPOOL_BLOCKS exceeds 32");
+
+EdgeAuxPool::EdgeAuxPool() : EdgeBlockPool<AutoConnectAux>(ED_AUXPOOL_BLOCKS) {}
+
+/**
+ * Creates an AutoConnectAux instance in a free block of the pool. If the
+ * pool has no free block, the instance is allocated from the heap.
+ * @return A pointer to the created AutoConnectAux instance.
+ */
+AutoConnectAux* EdgeAuxPool::create(void) {
+  AutoConnectAux* aux = acquire();
+  if (!aux) {
+    ED_DBG("EdgeAuxPool exhausted\n");
+    aux = new AutoConnectAux;
+  }
+  return aux;
+}
+
+/**
+ * Starts the HTTP response with unknown content length. The content will be
+ * sent in chunks through the Print interface.
+ * @param  server       WebServer that responds.
+ * @param  code         HTTP status code.
+ * @param  contentType  Content type of the response.
+ */
+EdgeChunkedResponse::EdgeChunkedResponse(EdgeUnifiedNS::WebServer& server, const int code, PGM_P contentType) : _server(server) {
+  _server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _server.send(code, String(FPSTR(contentType)).c_str(), "");
+}
+
+/**
+ * Sends the remaining chunk and terminates the chunked response.
+ */
+void EdgeChunkedResponse::end(void) {
+  if (!_ended) {
+    _flush();
+    _server.sendContent("");
+    _ended = true;
+  }
+}
+
+size_t EdgeChunkedResponse::write(uint8_t c) {
+  if (_len >= sizeof(_buffer))
+    _flush();
+  _buffer[_len++] = static_cast<char>(c);
+  return 1;
+}
+
+size_t EdgeChunkedResponse::write(const uint8_t* buffer, size_t size) {
+  size_t  remain = size;
+  while (remain) {
+    if (_len >= sizeof(_buffer))
+      _flush();
+    size_t  len = std::min(remain, sizeof(_buffer) - _len);
+    memcpy(_buffer + _len, buffer, len);
+    _len += len;
+    buffer += len;
+    remain -= len;
+  }
+  return size;
+}
+
+void EdgeChunkedResponse::_flush(void) {
+  if (_len) {
+    _server.sendContent(_buffer, _len);
+    _len = 0;
+  }
+}
+
+/**
+ * Evaluates the prerequisite. The EdgeDriver as the prerequisite holds while
+ * it is attached to EdgeUnified and has been started, not ended yet.
+ * @return true   The prerequisite holds.
+ */
+bool EdgeRequire::holds(void) const {
+  if (driver)
+    return driver->_edge && driver->_started && !driver->_gated;
+  return condition ? condition() : true;
+}
+
+/**
+ * The readiness condition of the WiFi station connected to the access point.
+ * EdgeUnified watches the WiFi events for its evaluation.
+ * @return EdgeRequire of the WiFi connection.
+ */
+EdgeRequire EdgeRequire::WiFiConnected(void) {
+  EdgeRequire require([]() { return WiFi.status() == WL_CONNECTED; });
+  require.wifi = true;
+  return require;
+}
+
+/**
+ * Attach EdgeDriver to EdgeUnified. The attached EdgeDriver is integrated
+ * into the event loop formed by the EdgeUnified, and EdgeDriver::process
+ * is called as an extension of the EdgeUnified::process function call.
+ * The EdgeDriver is placed in the event loop according to its priority.
+ * The EdgeData is also restored from the file system by the attach function
+ * when that EdgeDriver is in the EdgeDriver::autoRestore enabled state.
+ * @param  driver   EdgeDriver instance to be integrated into EdgeUnified.
+ * @param  interval Specifies the period interval at which the EdgeDriver::
+ * process is allowed to run. If a negative value is specified, the current
+ * interval is not changed.
+ */
+void EdgeUnified::attach(EdgeDriverBase& driver, const long interval) {
+  ED_DBG("Attaching driver...");
+  _drivers.insert(std::upper_bound(_drivers.begin(), _drivers.end(), driver, [](const EdgeDriverBase& lhs, const EdgeDriverBase& rhs) {
+    return lhs._priority > rhs._priority;
+  }), driver);
+  driver._edge = this;
+  if (!driver._traceId)
+    driver._traceId = ++_traceIds;
+  if (driver._slack)
+    _coalesce = true;
+  ED_TRACE(this, ED_TRACE_ATTACH, driver._traceId);
+  ED_DBG_DUMB("%s\n", driver.getTypeName().c_str());
+  if (driver._ready()) {
+    driver.start(interval);
+    return;
+  }
+
+  // The EdgeDriver waits for its prerequisites
+  if (interval >= 0)
+    driver.setEdgeInterval(interval);
+  driver._gated = true;
+  driver._setEnable(false);
+  ED_DBG("%s waits for the prerequisites\n", driver.getTypeName().c_str());
+}
+
+/**
+ * Attach EdgeDriver to EdgeUnified together with the AutoConnectAux pages
+ * which the EdgeDriver owns. EdgeUnified joins the pages while the EdgeDriver
+ * is enabled and releases them when the EdgeDriver is disabled, ended,
+ * aborted by an error, or detached. The sketch does not need to join and
+ * release the pages according to the EdgeDriver state.
+ * @param  driver   EdgeDriver instance to be integrated into EdgeUnified.
+ * @param  pages    Array of JSON and the request handler pairs owned by the
+ * EdgeDriver.
+ * @param  interval Specifies the period interval at which the EdgeDriver::
+ * process is allowed to run. If a negative value is specified, the current
+ * interval is not changed.
+ */
+void EdgeUnified::attach(EdgeDriverBase& driver, const std::vector<EdgeAux>& pages, const long interval) {
+  driver._pages = pages;
+  attach(driver, interval);
+}
+
+/**
+ * Attach EdgeDriver to EdgeUnified with its prerequisites. The EdgeDriver
+ * starts once all the prerequisites hold, and EdgeUnified starts the
+ * EdgeDrivers in the order of their dependencies. When one of the
+ * prerequisites no longer holds, the EdgeDriver is ended after its own
+ * dependents and waits for the prerequisites again. The prerequisites are
+ * evaluated only when an EdgeDriver has started or ended, the WiFi
+ * connection has changed, or the sketch has called EdgeUnified::recheck.
+ * @param  driver        EdgeDriver instance to be integrated into EdgeUnified.
+ * @param  prerequisites Array of the EdgeDrivers and the readiness
+ * conditions required to start the EdgeDriver.
+ * @param  interval      Specifies the period interval at which the
+ * EdgeDriver::process is allowed to run. If a negative value is specified,
+ * the current interval is not changed.
+ */
+void EdgeUnified::attach(EdgeDriverBase& driver, const std::vector<EdgeRequire>& prerequisites, const long interval) {
+  driver._requires = prerequisites;
+  for (const EdgeRequire& require : prerequisites)
+    if (require.wifi)
+      _watchWiFi();
+  attach(driver, interval);
+}
+
+/**
+ * Consolidate multiple EdgeDrivers into EdgeUnified at once.
+ * @param  drivers  Array of EdgeDriver instances to be integrated
+ * into EdgeUnified.
+ */
+void EdgeUnified::attach(std::vector<std::reference_wrapper<EdgeDriverBase>> drivers) {
+  for (EdgeDriverBase& driver : drivers) {
+    attach(driver);
+  }
+}
+
+/**
+ * Detach a EdgeDriver from EdgeUnified. Also it calls EdgeDriver's end
+ * callback upon detachment. The AutoConnectAux pages owned by the EdgeDriver
+ * are released.
+ * @param  driver EdgeDriver instance to be detached from EdgeUnified.
+ */
+void EdgeUnified::detach(const EdgeDriverBase& driver) {
+  std::vector<std::reference_wrapper<EdgeDriverBase>>::iterator it = std::find_if(_drivers.begin(), _drivers.end(), [&](const EdgeDriverBase& _driver) {
+    return std::addressof(driver) == std::addressof(_driver);
+  });
+  if (it == _drivers.end())
+    return;
+
+  EdgeDriverBase& _driver = *it;
+  for (const String& uri : _driver._pageUris)
+    release(uri);
+  _driver._pageUris.clear();
+  _driver._edge = nullptr;
+  _gateChanged = true;
+  _drivers.erase(it);
+}
+
+/**
+ * Enables the duty-cycle mode. The node wakes, runs every due EdgeDriver
+ * once, and sleeps again. After each turn of EdgeUnified::process, if the
+ * next wake is not closer than the minimum sleep, EdgeUnified ends the
+ * EdgeDrivers in the reverse order of their dependencies, saves EdgeData of
+ * the auto-save EdgeDrivers only if it has changed, and enters the deep
+ * sleep with the timer wake until the next due EdgeDriver. The schedules of
+ * the EdgeDrivers are kept over the deep sleep, and at the wake the due
+ * EdgeDrivers run in the first turn. While the jobs or the prerequisites are
+ * pending, the node stays awake up to the awake limit since the dutyCycle
+ * function was called in the setup at the reset or the wake.
+ * The dutyCycle function should be called before attaching the EdgeDrivers
+ * in the setup, and the sketch can skip the portal if resumed returns true.
+ * ESP8266 requires GPIO16 to be wired to RST for the timer wake.
+ * @param  minSleep   Shortest sleep [ms] worth entering the deep sleep.
+ * @param  awakeLimit Limit [ms] of the awake time waiting for the pending
+ * jobs and prerequisites.
+ */
+void EdgeUnified::dutyCycle(const unsigned long minSleep, const unsigned long awakeLimit) {
+  _dutyCycle = true;
+  _dutyMinSleep = minSleep;
+  _dutyAwakeLimit = awakeLimit;
+  _dutyTm = millis();
+
+  if (!resumed()) {
+    // The first cycle runs every EdgeDriver at once
+    memset(&_edgeDutyState, 0, sizeof(_edgeDutyState));
+    _edgeDutyState.magic = ED_DUTY_MAGIC;
+    _edgeDutyState.drivers = ED_DUTY_DRIVERS;
+  }
+  _dutyResume = _edgeDutyState.drivers >= 32 ? UINT32_MAX : (1UL << _edgeDutyState.drivers) - 1;
+}
+
+/**
+ * Outputs the awake time of the duty cycles.
+ * @param  out  Output destination such as Serial.
+ * @return The size of the output.
+ */
+size_t EdgeUnified::dutyReport(Print& out) {
+  char  line[96];
+  snprintf(line, sizeof(line), "cycle %lu, awake %lu ms, last awake %lu ms, average %lu ms, slept %lu ms\n",
+    static_cast<unsigned long>(_edgeDutyState.cycles), millis(),
+    static_cast<unsigned long>(_edgeDutyState.awake),
+    static_cast<unsigned long>(_edgeDutyState.cycles ? _edgeDutyState.awakeTotal / _edgeDutyState.cycles : 0),
+    static_cast<unsigned long>(_edgeDutyState.sleep));
+  return out.print(line);
+}
+
+/**
+ * Pair the JSON description of the AutoConnectAux custom web page with the
+ * request handler and bind it to EdgeUnified. If EdgeUnified does not own
+ * the AutoConnect instance at the time of binding (i.e. AutoConnect::begin
+ * has not run), EdgeUnified will delay loading the AutoConnectAux JSON.
+ * @param  json       Pointer to JSON description of the AutoConnectAux.
+ * @param  auxHandler AutoConnectAux request handler.
+ */
+void EdgeUnified::join(PGM_P json, AuxHandlerFunctionT auxHandler) {
+  EdgeAux aux(json, auxHandler);
+  join({ aux });
+}
+
+/**
+ * Pair the JSON description of the AutoConnectAux custom web page with the
+ * request handler and bind it to EdgeUnified. If EdgeUnified does not own
+ * the AutoConnect instance at the time of binding (i.e. AutoConnect::begin
+ * has not run), EdgeUnified will delay loading the AutoConnectAux JSON.
+ * @param  json       __FlashStringHelper pointer through PROGMEM area. When
+ * the PROGMEM attribute is given to the JSON description and placed in the
+ * flash area, the JSON description is passed through the FPSTR macro.
+ * @param  auxHandler AutoConnectAux request handler.
+ */
+void EdgeUnified::join(const __FlashStringHelper* json, AuxHandlerFunctionT auxHandler) {
+  EdgeAux aux(json, auxHandler);
+  join({ aux });
+}
+
+/**
+ * Combines multiple JSON description of the AutoConnectAux custom web page
+ * and the request handler pairs into EdgeUnified at once.
+ * If page specifier has the `FILE:` identifier, the join try to load JSON
+ * from the file.
+ * The join keeps the fingerprint of the JSON description for each joined
+ * page. Re-joining a page with the same JSON description only rebinds the
+ * request handler without parsing the JSON again. If the JSON description
+ * has changed, the newly loaded AutoConnectAux replaces the one with the
+ * same uri.
+ * @param  pages  Array of JSON and the request handler pairs.
+ */
+void EdgeUnified::join(const std::vector<EdgeAux>& pages) {
+  for (const EdgeAux& page : pages)
+    _join(page);
+}
+
+/**
+ * Calls the on-error callback of all EdgeDrivers bound to EdgeUnified to abort
+ * processing. Once the error callback is called, the EdgeDriver's process
+ * callback is disabled until the EdgeDriver::start function is executed.
+ * @param  error  Error code. The value should be uniquely defined by the user
+ * sketch according to the EdgeDriver properties. EdgeUnified is not involved
+ * in the value and semantics of the error code.
+ */
+void EdgeUnified::abort(const int error) {
+  for (EdgeDriverBase& driver : _drivers)
+    driver.error(error);
+}
+
+/**
+ * Serves the EdgeData of the attached EdgeDrivers as the REST endpoint on
+ * the WebServer hosted by AutoConnect. The EdgeData of each EdgeDriver can
+ * be accessed as JSON at ED_API_PATH/<type name of EdgeData>.
+ * GET streams the EdgeData output by the serializer of EdgeDriver to the
+ * client in chunks, and PUT applies the JSON body through the deserializer.
+ * GET ED_API_PATH responds to the list of the type names. The api function
+ * must be called after AutoConnect::begin and the AutoConnect instance has
+ * been bound to EdgeUnified with EdgeUnified::portal.
+ * @return true   The REST endpoint has been registered to the WebServer.
+ * @return false  AutoConnect is not bound yet.
+ */
+bool EdgeUnified::api(void) {
+  if (!_portal) {
+    ED_DBG("REST api, AutoConnect not bound\n");
+    return false;
+  }
+
+  // Only the routes with the braces have the path argument.
+  server().on(ED_API_PATH, HTTP_GET, [this]() { _apiList(); });
+  server().on(UriBraces(ED_API_PATH "/{}"), HTTP_GET, [this]() { _apiGet(server().pathArg(0)); });
+  server().on(UriBraces(ED_API_PATH "/{}"), HTTP_PUT, [this]() { _apiPut(server().pathArg(0)); });
+  return true;
+}
+
+/**
+ * Serves the telemetry of EdgeDrivers as Server-Sent Events on the WebServer
+ * hosted by AutoConnect. EdgeUnified keeps up to ED_EVENTS_MAX_CLIENTS
+ * connections to ED_EVENTS_PATH and pushes the changed fields of EdgeData
+ * enabled by EdgeDriver::telemetry from the process function. The changes
+ * of all EdgeDrivers are batched into one event as the JSON object keyed by
+ * the type name of EdgeData. Like the api function, the events function
+ * must be called after AutoConnect::begin and the AutoConnect instance has
+ * been bound to EdgeUnified.
+ * @param  interval Minimum interval [ms] between the events.
+ * @return true   The events endpoint has been registered to the WebServer.
+ * @return false  AutoConnect is not bound yet.
+ */
+bool EdgeUnified::events(const unsigned long interval) {
+  if (!_portal) {
+    ED_DBG("Events, AutoConnect not bound\n");
+    return false;
+  }
+
+  _eventsInterval = interval;
+  _eventClients.resize(ED_EVENTS_MAX_CLIENTS);
+  server().on(ED_EVENTS_PATH, HTTP_GET, [this]() { _acceptEvents(); });
+  return true;
+}
+
+/**
+ * Registers the status endpoint of the submitted jobs with the web server
+ * hosted by AutoConnect. GET ED_JOBS_PATH returns the states of the jobs
+ * in the queue and the recently completed jobs, and GET ED_JOBS_PATH/{id}
+ * returns the state of the job specified by the identifier which the
+ * submit function returned.
+ * The jobs function should be called after AutoConnect::begin and
+ * EdgeUnified::portal.
+ * @return true   The endpoint has been registered.
+ * @return false  AutoConnect has not been bound to EdgeUnified.
+ */
+bool EdgeUnified::jobs(void) {
+  if (!_portal) {
+    ED_DBG("Jobs endpoint, AutoConnect not bound\n");
+    return false;
+  }
+
+  // Only the route with the braces has the path argument.
+  server().on(ED_JOBS_PATH, HTTP_GET, [this]() { _jobsGet(String()); });
+  server().on(UriBraces(ED_JOBS_PATH "/{}"), HTTP_GET, [this]() { _jobsGet(server().pathArg(0)); });
+  return true;
+}
+
+/**
+ * Registers the restart history endpoint of the supervised EdgeDrivers with
+ * the web server hosted by AutoConnect. GET ED_SUPERVISOR_PATH returns the
+ * recent restarts and escalations up to ED_SUPERVISOR_HISTORY as a JSON
+ * array, and the restarts pending.
+ * The supervisor function should be called after AutoConnect::begin and
+ * EdgeUnified::portal.
+ * @return true   The endpoint has been registered.
+ * @return false  AutoConnect has not been bound to EdgeUnified.
+ */
+bool EdgeUnified::supervisor(void) {
+  if (!_portal) {
+    ED_DBG("Supervisor endpoint, AutoConnect not bound\n");
+    return false;
+  }
+
+  server().on(ED_SUPERVISOR_PATH, HTTP_GET, [this]() { _supervisorGet(); });
+  return true;
+}
+
+/**
+ * Registers the endpoint that exports the recorded lifecycle events in the
+ * Chrome trace JSON format with the web server hosted by AutoConnect. The
+ * response of GET ED_TRACE_PATH can be opened with Perfetto or
+ * chrome://tracing as it is.
+ * The trace function should be called after AutoConnect::begin and
+ * EdgeUnified::portal.
+ * @return true   The endpoint has been registered.
+ * @return false  AutoConnect has not been bound to EdgeUnified, or the
+ * trace is disabled by ED_TRACE_SIZE.
+ */
+bool EdgeUnified::trace(void) {
+#if ED_TRACE_SIZE
+  if (!_portal) {
+    ED_DBG("Trace endpoint, AutoConnect not bound\n");
+    return false;
+  }
+
+  server().on(ED_TRACE_PATH, HTTP_GET, [this]() {
+    EdgeChunkedResponse response(server(), 200, PSTR("application/json"));
+    traceDump(response);
+  });
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Registers the boot report endpoint at ED_BOOT_PATH with the WebServer of
+ * the bound AutoConnect. The endpoint responds with the output of the
+ * bootReport function.
+ * @return true   The endpoint has been registered.
+ * @return false  AutoConnect is not bound, or the boot timeline is not built.
+ */
+bool EdgeUnified::boot(void) {
+#if ED_BOOT_PHASES
+  if (!_portal) {
+    ED_DBG("Boot endpoint, AutoConnect not bound\n");
+    return false;
+  }
+
+  server().on(ED_BOOT_PATH, HTTP_GET, [this]() {
+    EdgeChunkedResponse response(server(), 200, PSTR("text/plain"));
+    bootReport(response);
+  });
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Places a mark on the boot timeline at the milestone of the sketch or the
+ * EdgeDriver. A mark is recorded once for each phase string and EdgeDriver,
+ * so it can be placed on a path that runs repeatedly.
+ * @param  phase  Name of the milestone.
+ * @param  driver EdgeDriver that reached the milestone.
+ */
+void EdgeUnified::bootMark(PGM_P phase, const EdgeDriverBase* driver) {
+#if ED_BOOT_PHASES
+  _boot.mark(phase, driver ? driver->_traceId : 0);
+#else
+  (void)phase;
+  (void)driver;
+#endif
+}
+
+/**
+ * Outputs the boot timeline. Each line has the time when the phase began
+ * and its duration in microseconds since the reset, and the nested phases
+ * are indented. The last line is the time when the first turn of the
+ * process completed the boot.
+ * @param  out  Output destination such as Serial.
+ * @return The size of the output.
+ */
+size_t EdgeUnified::bootReport(Print& out) {
+#if ED_BOOT_PHASES
+  return _boot.report(out, [this](uint16_t id) {
+    for (EdgeDriverBase& driver : _drivers)
+      if (driver._traceId == id)
+        return driver.getTypeName();
+    return String(F("EdgeDriver#")) + String(id);
+  });
+#else
+  (void)out;
+  return 0;
+#endif
+}
+
+/**
+ * Outputs the memory consumed by each attached EdgeDriver. The size is the
+ * size of the concrete EdgeDriver class when it was attached with its own
+ * type, otherwise that of EdgeDriver<T> marked with an asterisk. The heap
+ * is the change of the free heap accumulated across the callbacks, the
+ * persistence and the page joins of the EdgeDriver with ED_HEAP_ACCOUNTING,
+ * and it includes the allocations that the other tasks made at the same time.
+ * @param  out  Output destination such as Serial.
+ * @return The size of the output.
+ */
+size_t EdgeUnified::memoryReport(Print& out) {
+  char  num[40];
+  size_t  len = out.print(F("   size[B]   data[B]   heap[B]  driver\n"));
+
+  for (EdgeDriverBase& driver : _drivers) {
+    size_t  size = driver._footprint ? driver._footprint : driver._driverSize();
+#if ED_HEAP_ACCOUNTING
+    snprintf(num, sizeof(num), "%10u%10u%10ld  ", static_cast<unsigned int>(size), static_cast<unsigned int>(driver._dataSize()), static_cast<long>(driver._heap));
+#else
+    snprintf(num, sizeof(num), "%10u%10u%10s  ", static_cast<unsigned int>(size), static_cast<unsigned int>(driver._dataSize()), "-");
+#endif
+    len += out.print(num);
+    len += out.print(driver.getTypeName());
+    if (!driver._footprint)
+      len += out.print('*');
+    len += out.print('\n');
+  }
+  return len;
+}
+
+/**
+ * Registers the metrics endpoint at ED_METRICS_PATH with the WebServer of
+ * the bound AutoConnect. The endpoint responds to the scrape of Prometheus
+ * with the output of the metricsDump function.
+ * @return true   The endpoint has been registered.
+ * @return false  AutoConnect is not bound.
+ */
+bool EdgeUnified::metrics(void) {
+  if (!_portal) {
+    ED_DBG("Metrics endpoint, AutoConnect not bound\n");
+    return false;
+  }
+
+  server().on(ED_METRICS_PATH, HTTP_GET, [this]() {
+    EdgeChunkedResponse response(server(), 200, PSTR("text/plain; version=0.0.4"));
+    metricsDump(response);
+  });
+  return true;
+}
+
+/**
+ * Outputs the metrics of EdgeUnified and the attached EdgeDrivers in the
+ * Prometheus text exposition format. The samples of the EdgeDrivers are
+ * labeled with the type of their EdgeData and with the id given at the
+ * attach, which tells apart the EdgeDrivers of the same type. The metrics
+ * registered by the EdgeDrivers with the same name are grouped into one
+ * family. The output is written sample by sample without building the
+ * whole body.
+ * @param  out  Output destination such as EdgeChunkedResponse.
+ * @return The size of the output.
+ */
+size_t EdgeUnified::metricsDump(Print& out) {
+  size_t  len = 0;
+
+  auto  family = [&](PGM_P name, PGM_P help, const bool counter) {
+    len += out.print(F("# HELP edge_"));
+    len += out.print(FPSTR(name));
+    len += out.print(' ');
+    len += out.print(FPSTR(help));
+    len += out.print(F("\n# TYPE edge_"));
+    len += out.print(FPSTR(name));
+    len += out.print(counter ? F(" counter\n") : F(" gauge\n"));
+  };
+
+  auto  sample = [&](PGM_P name, EdgeDriverBase* driver, const double value) {
+    char  num[24];
+    len += out.print(F("edge_"));
+    len += out.print(FPSTR(name));
+    if (driver) {
+      len += out.print(F("{driver=\""));
+      len += out.print(driver->getTypeName());
+      len += out.print(F("\",id=\""));
+      len += out.print(driver->_traceId);
+      len += out.print(F("\"}"));
+    }
+    snprintf(num, sizeof(num), " %.12g\n", value);
+    len += out.print(num);
+  };
+
+  auto  drivers = [&](PGM_P name, PGM_P help, const bool counter, double (*value)(const EdgeDriverBase&)) {
+    family(name, help, counter);
+    for (EdgeDriverBase& driver : _drivers)
+      sample(name, &driver, value(driver));
+  };
+
+  family(PSTR("loop_iterations_total"), PSTR("Number of the EdgeUnified::process calls."), true);
+  sample(PSTR("loop_iterations_total"), nullptr, _loops);
+  family(PSTR("loop_rate"), PSTR("EdgeUnified::process calls per second."), false);
+  sample(PSTR("loop_rate"), nullptr, _loopRate);
+  family(PSTR("joins_total"), PSTR("Number of the AutoConnectAux joined."), true);
+  sample(PSTR("joins_total"), nullptr, _joins);
+  family(PSTR("releases_total"), PSTR("Number of the AutoConnectAux released."), true);
+  sample(PSTR("releases_total"), nullptr, _releases);
+  if (_dutyCycle) {
+    family(PSTR("duty_cycles_total"), PSTR("Number of the deep sleeps of the duty cycle."), true);
+    sample(PSTR("duty_cycles_total"), nullptr, _edgeDutyState.cycles);
+    family(PSTR("duty_awake_seconds"), PSTR("Awake time of the last duty cycle."), false);
+    sample(PSTR("duty_awake_seconds"), nullptr, _edgeDutyState.awake / 1e3);
+  }
+  family(PSTR("heap_free_bytes"), PSTR("Free heap size."), false);
+  sample(PSTR("heap_free_bytes"), nullptr, ESP.getFreeHeap());
+  family(PSTR("heap_max_block_bytes"), PSTR("Largest allocatable heap block."), false);
+#if defined(ARDUINO_ARCH_ESP8266)
+  sample(PSTR("heap_max_block_bytes"), nullptr, ESP.getMaxFreeBlockSize());
+#elif defined(ARDUINO_ARCH_ESP32)
+  sample(PSTR("heap_max_block_bytes"), nullptr, ESP.getMaxAllocHeap());
+#endif
+
+  drivers(PSTR("driver_processes_total"), PSTR("Number of the process calls."), true,
+    [](const EdgeDriverBase& driver) { return static_cast<double>(driver._stats.processes); });
+  drivers(PSTR("driver_process_seconds_total"), PSTR("Total time of the process calls."), true,
+    [](const EdgeDriverBase& driver) { return driver._stats.processTime / 1e6; });
+  drivers(PSTR("driver_process_max_seconds"), PSTR("Longest process call."), false,
+    [](const EdgeDriverBase& driver) { return driver._stats.processMax / 1e6; });
+  drivers(PSTR("driver_overruns_total"), PSTR("Process calls exceeding the budget."), true,
+    [](const EdgeDriverBase& driver) { return static_cast<double>(driver._stats.overruns); });
+  drivers(PSTR("driver_errors_total"), PSTR("Number of the errors."), true,
+    [](const EdgeDriverBase& driver) { return static_cast<double>(driver._stats.errors); });
+  drivers(PSTR("driver_restarts_total"), PSTR("Number of the restarts by the supervisor."), true,
+    [](const EdgeDriverBase& driver) { return static_cast<double>(driver._stats.restarts); });
+  drivers(PSTR("driver_saves_total"), PSTR("Number of the EdgeData saves."), true,
+    [](const EdgeDriverBase& driver) { return static_cast<double>(driver._stats.saves); });
+  drivers(PSTR("driver_save_bytes_total"), PSTR("Total size of the saved EdgeData."), true,
+    [](const EdgeDriverBase& driver) { return static_cast<double>(driver._stats.saveBytes); });
+  drivers(PSTR("driver_save_seconds_total"), PSTR("Total time of the EdgeData saves."), true,
+    [](const EdgeDriverBase& driver) { return driver._stats.saveTime / 1e6; });
+  drivers(PSTR("driver_restores_total"), PSTR("Number of the EdgeData restorations."), true,
+    [](const EdgeDriverBase& driver) { return static_cast<double>(driver._stats.restores); });
+  drivers(PSTR("driver_restore_bytes_total"), PSTR("Total size of the restored EdgeData."), true,
+    [](const EdgeDriverBase& driver) { return static_cast<double>(driver._stats.restoreBytes); });
+  drivers(PSTR("driver_restore_seconds_total"), PSTR("Total time of the EdgeData restorations."), true,
+    [](const EdgeDriverBase& driver) { return driver._stats.restoreTime / 1e6; });
+  drivers(PSTR("driver_footprint_bytes"), PSTR("Size of the EdgeDriver instance."), false,
+    [](const EdgeDriverBase& driver) { return static_cast<double>(driver._footprint ? driver._footprint : driver._driverSize()); });
+  drivers(PSTR("driver_data_bytes"), PSTR("Size of the EdgeData."), false,
+    [](const EdgeDriverBase& driver) { return static_cast<double>(driver._dataSize()); });
+#if ED_HEAP_ACCOUNTING
+  drivers(PSTR("driver_heap_bytes"), PSTR("Heap attributed to the EdgeDriver."), false,
+    [](const EdgeDriverBase& driver) { return static_cast<double>(driver._heap); });
+#endif
+
+  // The metrics registered by the EdgeDrivers. A family is written at the
+  // first EdgeDriver that registered its name, together with the samples
+  // of the following EdgeDrivers.
+  auto  same = [](PGM_P a, PGM_P b) { return a == b || String(FPSTR(a)) == String(FPSTR(b)); };
+  for (size_t d = 0; d < _drivers.size(); d++) {
+    std::vector<EdgeDriverBase::EdgeMetric_t>&  metrics = _drivers[d].get()._metrics;
+    for (size_t m = 0; m < metrics.size(); m++) {
+      bool  written = false;
+      for (size_t e = 0; e <= d && !written; e++) {
+        const std::vector<EdgeDriverBase::EdgeMetric_t>&  earlier = _drivers[e].get()._metrics;
+        for (size_t n = 0; n < (e < d ? earlier.size() : m) && !written; n++)
+          written = same(earlier[n].name, metrics[m].name);
+      }
+      if (written)
+        continue;
+
+      family(metrics[m].name, metrics[m].help, metrics[m].counter);
+      for (size_t e = d; e < _drivers.size(); e++)
+        for (EdgeDriverBase::EdgeMetric_t& metric : _drivers[e].get()._metrics)
+          if (same(metric.name, metrics[m].name) && metric.reader)
+            sample(metric.name, &_drivers[e].get(), metric.reader());
+    }
+  }
+  return len;
+}
+
+/**
+ * Outputs the recorded lifecycle events in the Chrome trace JSON format.
+ * The process of each EdgeDriver appears as a duration on the track named
+ * with the type of its EdgeData, and the other events as the instants.
+ * @param  out  Output destination such as Serial.
+ * @return The size of the output.
+ */
+size_t EdgeUnified::traceDump(Print& out) {
+#if ED_TRACE_SIZE
+  return _trace.dump(out, [this](uint16_t id) {
+    if (!id)
+      return String(F("EdgeUnified"));
+    for (EdgeDriverBase& driver : _drivers)
+      if (driver._traceId == id)
+        return driver.getTypeName();
+    return String(F("EdgeDriver#")) + String(id);
+  });
+#else
+  (void)out;
+  return 0;
+#endif
+}
+
+/**
+ * Calls the end callback of all EdgeDrivers bound to EdgeUnified to end
+ * processing.
+ */
+void EdgeUnified::end(void) {
+  for (EdgeDriverBase& driver : _drivers)
+    driver.end();
+}
+
+/**
+ * Loads the JSON custom web page descriptions which have not yet loaded into
+ * AutoConnect among those bound to EdgeUnified.
+ * @param  portal A reference to the AutoConnect instance.
+ */
+void EdgeUnified::portal(AutoConnect& portal) {
+  if (!_portal)
+    _portal = &portal;
+  
+  if (_auxQueue.size()) {
+    ED_BOOT_PHASE(this, "portal", 0);
+    std::deque<AutoConnectAux*> queued;
+    queued.swap(_auxQueue);
+    for (AutoConnectAux* aux : queued)
+      _joinAux(aux);
+  }
+}
+
+/**
+ * Consecutively calls the process function of the EdgeDrivers bound to the
  * EdgeUnifined to execute an event loop.
  * EdgeUnified::process function with the portal argument allows EdgeUnified
  * to dynamically load and bind AutoConnectAux. Sketches can release and join
@@ -424,86 +1803,1448 @@ void EdgeUnified::portal(AutoConnect& portal) {
  * with a portal argument.
  * @param  portal A reference to the AutoConnect instance.
  */
-void EdgeUnified::process(AutoConnect& portal) {
-  // Bind AutoConnectAuxes waiting to join the portal to AutoConnect
-  EdgeUnified::portal(portal);
-  process();
+void EdgeUnified::process(AutoConnect& portal) {
+  // Bind AutoConnectAuxes waiting to join the portal to AutoConnect
+  EdgeUnified::portal(portal);
+  process();
+}
+
+/**
+ * Consecutively calls the process function of the EdgeDrivers bound to the
+ * EdgeUnifined to execute an event loop.
+ */
+void EdgeUnified::process(void) {
+#if ED_BOOT_PHASES
+  // The first turn completes the boot timeline
+  size_t  firstTurn = _boot.begin(PSTR("first process"), 0);
+#endif
+
+  // Start or end the EdgeDrivers whose prerequisites have changed
+  if (_gateChanged)
+    _gate();
+
+  // Take over the schedules kept over the deep sleep
+  if (_dutyResume) {
+    for (EdgeDriverBase& driver : _drivers)
+      if (driver._started)
+        _resume(driver);
+  }
+
+  // Open the wake slot when the earliest EdgeDriver reaches its slack
+  if (_coalesce)
+    _slot = _wake(millis()) <= 0;
+
+  // Loop for EdgeDrivers
+  for (EdgeDriverBase& driver : _drivers)
+    driver.process();
+
+  // Restart the supervised EdgeDrivers whose delay has passed
+  if (_restartsPending)
+    _supervise();
+
+  // The EdgeDrivers demoted or given a priority in the loop take their new order
+  if (_reorder) {
+    _reorder = false;
+    _prioritize();
+  }
+
+#if ED_BOOT_PHASES
+  if (firstTurn < ED_BOOT_PHASES) {
+    _boot.end(firstTurn);
+    _boot.finish();
+  }
+#endif
+
+  // Rate of the loop for the metrics
+  _loops++;
+  if (millis() - _loopsTm >= 1000) {
+    _loopRate = (_loops - _loopsMark) * 1000.0f / (millis() - _loopsTm);
+    _loopsMark = _loops;
+    _loopsTm = millis();
+  }
+
+  // Run a slice of the submitted job, and report the completed jobs
+  if (_jobs.size())
+    _runJobs();
+
+  // Push the telemetry to the Server-Sent Events connections
+  if (_eventsInterval && millis() - _eventsTm >= _eventsInterval) {
+    _eventsTm = millis();
+    _pushEvents();
+  }
+
+#if defined(ED_DEBUG) && ED_DEBUG_DEFERRED
+  // The deferred debug output takes the rest of the turn
+  EdgeDebugLog.drain(ED_DEBUG_PORT);
+#endif
+
+  // Sleep until the next due EdgeDriver
+  if (_dutyCycle)
+    _duty();
+}
+
+/**
+ * Queries the sleep opportunity of the event loop. It is the time until
+ * the next wake slot in which some EdgeDriver::process is due, also
+ * the supervisor restarts and the telemetry events are taken into account.
+ * The sketch can light sleep for the time between EdgeUnified::process
+ * calls without delaying any EdgeDriver beyond its slack.
+ * @return The time [ms] until the next wake slot. Zero means that the loop
+ * should not sleep, such as the EdgeDriver without the interval is running
+ * or the jobs are pending. ULONG_MAX means that no wakeup is scheduled.
+ */
+unsigned long EdgeUnified::nextWake(void) {
+  if (_jobs.size() || _gateChanged)
+    return 0;
+  for (EdgeDriverBase& driver : _drivers)
+    if (driver._busy())
+      return 0;
+
+  const unsigned long now = millis();
+  long  wake = _wake(now);
+  for (EdgeDriverBase& driver : _drivers)
+    if (driver._restartPending)
+      wake = std::min(wake, static_cast<long>(driver._restartDelay - (now - driver._restartTm)));
+  if (_eventsInterval)
+    wake = std::min(wake, static_cast<long>(_eventsInterval - (now - _eventsTm)));
+
+  if (wake == LONG_MAX)
+    return ULONG_MAX;
+  return wake > 0 ? static_cast<unsigned long>(wake) : 0;
+}
+
+/**
+ * Determines whether the node has woken from the deep sleep of the duty
+ * cycle. The schedules of the EdgeDrivers have been kept, and the sketch
+ * can resume without the portal if no configuration is needed.
+ * @return true   Woken by the timer of the duty cycle.
+ */
+bool EdgeUnified::resumed(void) {
+#if defined(ARDUINO_ARCH_ESP8266)
+  if (ESP.getResetInfoPtr()->reason != REASON_DEEP_SLEEP_AWAKE)
+    return false;
+  if (_edgeDutyState.magic != ED_DUTY_MAGIC)
+    ESP.rtcUserMemoryRead(ED_DUTY_RTCOFFSET, reinterpret_cast<uint32_t*>(&_edgeDutyState), sizeof(_edgeDutyState));
+#elif defined(ARDUINO_ARCH_ESP32)
+  if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER)
+    return false;
+#else
+  return false;
+#endif
+  return _edgeDutyState.magic == ED_DUTY_MAGIC && _edgeDutyState.digest == _edgeDutyDigest() && _edgeDutyState.drivers <= ED_DUTY_DRIVERS;
+}
+
+/**
+ * Releases AutoConnectAux with the specified uri from EdgeUnified.
+ * The AutoConnectAux which EdgeUnified has loaded by the join function is
+ * kept loaded up to ED_AUXPOOL_PARKS for the next join with the same JSON
+ * description. The oldest one that exceeds it will be deleted.
+ * @param  uri    Specify the uri of AutoConnectAux to be released from EdgeUnified.
+ * @return true   Released AutoConnectAux with specified uri from EdgeUnified.
+ * @return false  AutoConnectAux with specified uri is not joined.
+ */
+bool EdgeUnified::release(const String& uri) {
+  std::map<String, EdgeAuxEntry_t>::iterator  joined = _auxIndex.find(uri);
+  if (joined != _auxIndex.end()) {
+    ED_TRACE(this, ED_TRACE_RELEASE, _traceOwner);
+    _auxSource.erase(joined->second.fingerprint);
+    bool  rc = _detachAux(joined->second.aux);
+    _auxParked.push_back(joined->second);
+    _auxIndex.erase(joined);
+    while (_auxParked.size() > ED_AUXPOOL_PARKS) {
+      _auxPool.destroy(_auxParked.front().aux);
+      _auxParked.pop_front();
+    }
+    if (rc)
+      _releases++;
+    return rc;
+  }
+
+  if (!_portal) {
+    ED_DBG("Releasing %s, AutoConnect not bound\n", uri.c_str());
+    return false;
+  }
+  bool  rc = _portal->detach(uri);
+  if (rc)
+    _releases++;
+  return rc;
+}
+
+/**
+ * Restore EdgeDates using EdgeData::restore function of all EdgeDrivers bound
+ * to EdgeUnified. If the autoMount argument is set to true, the file system
+ * will automatically begin and end as needed.
+ * @param  autoMount  If True, the restore function tries to begin the
+ * specified file system. It also terminates the file system at the exit of
+ * the function.
+ */
+void EdgeUnified::restore(AUTOCONNECT_APPLIED_FILECLASS& fs, const bool autoMount) {
+
+  if (autoMount) {
+    bool  mounted = AutoConnectFS::_isMounted(&fs);
+    if (!mounted) {
+      ED_BOOT_PHASE(this, "mount", 0);
+      if (!fs.begin(AUTOCONNECT_FS_INITIALIZATION)) {
+        ED_DBG("%s mount failed\n", AUTOCONNECT_STRING_DEPLOY(AUTOCONNECT_APPLIED_FILESYSTEM));
+        return;
+      }
+    }
+  }
+
+  for (EdgeDriverBase& driver : _drivers)
+    driver.restore(fs, nullptr);
+
+  if (autoMount)
+    fs.end();
+}
+
+/**
+ * Save EdgeDates using EdgeData::save function of all EdgeDrivers bound to
+ * EdgeUnified. If the autoMount argument is set to true, the file system will
+ * automatically begin and end as needed.
+ * @param  autoMount  If True, the save function tries to begin the specified
+ * file system. It also terminates the file system at the exit of the function.
+ */
+void EdgeUnified::save(AUTOCONNECT_APPLIED_FILECLASS& fs, const bool autoMount) {
+  if (autoMount) { 
+    bool  mounted = AutoConnectFS::_isMounted(&fs);
+    if (!mounted) {
+      ED_BOOT_PHASE(this, "mount", 0);
+      if (!fs.begin(AUTOCONNECT_FS_INITIALIZATION)) {
+        ED_DBG("%s mount failed\n", AUTOCONNECT_STRING_DEPLOY(AUTOCONNECT_APPLIED_FILESYSTEM));
+        return;
+      }
+    }
+  }
+
+  for (EdgeDriverBase& driver : _drivers)
+    driver.save(fs, nullptr);
+
+  if (autoMount)
+    fs.end();
+}
+
+/**
+ * Submits a job to be run outside the caller. It allows a request handler
+ * of AutoConnectAux to return the response immediately instead of blocking
+ * the web server and the other EdgeDrivers with a lengthy work. The job is
+ * called once per turn of EdgeUnified::process until it returns other than
+ * ED_JOB_CONTINUE, so a long job should be split into slices. If
+ * ED_JOB_WORKER is enabled on ESP32, the job runs on the worker task
+ * instead, and it must not touch the resources the loop task uses without
+ * a guard. In both cases, the completion callback is called from the
+ * EdgeUnified::process.
+ * @param  job  Job function.
+ * @param  done Completion callback which receives the identifier and the
+ * result of the job.
+ * @return The identifier of the submitted job. If it is zero, the job queue
+ * is full and the job is not submitted.
+ */
+uint16_t EdgeUnified::submit(EdgeJobT job, EdgeJobDoneT done) {
+  if (!job)
+    return 0;
+
+#ifdef ED_JOB_WORKER_ENABLED
+  if (!_jobsLock)
+    _jobsLock = xSemaphoreCreateMutex();
+  if (!_jobsTask)
+    xTaskCreate(_jobWorker, "EdgeJob", ED_JOB_WORKER_STACK, this, ED_JOB_WORKER_PRIORITY, &_jobsTask);
+#endif
+
+  _lockJobs();
+  if (_jobs.size() >= ED_JOB_QUEUE_SIZE) {
+    _unlockJobs();
+    ED_DBG("Job queue full\n");
+    return 0;
+  }
+  if (!++_jobId)
+    _jobId++;
+  _jobs.push_back({ _jobId, job, done, 0, ED_JOB_PENDING });
+  uint16_t  id = _jobId;
+  _unlockJobs();
+
+#ifdef ED_JOB_WORKER_ENABLED
+  if (_jobsTask)
+    xTaskNotifyGive(_jobsTask);
+#endif
+  return id;
+}
+
+/**
+ * Accepts the Server-Sent Events connection. The connection is kept in a
+ * free slot and the next event will send all fields of the telemetry. If
+ * there is no free slot, the request is rejected with 503.
+ */
+void EdgeUnified::_acceptEvents(void) {
+  EdgeUnifiedNS::WebServer& webServer = server();
+
+  for (WiFiClient& client : _eventClients) {
+    if (!client.connected()) {
+      client = webServer.client();
+      client.setNoDelay(true);
+      client.print(F("HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Connection: keep-alive\r\n\r\n"));
+      _eventsFull = true;
+      _eventsTm = millis() - _eventsInterval;
+      ED_DBG("Events subscribed\n");
+      return;
+    }
+  }
+  webServer.send(503, "text/plain", F("Too many subscribers"));
+}
+
+/**
+ * Responds to the GET request for ED_API_PATH with the list of the type
+ * names of the attached EdgeDrivers.
+ */
+void EdgeUnified::_apiList(void) {
+  EdgeChunkedResponse response(server(), 200, PSTR("application/json"));
+  char  dlm = '[';
+  for (EdgeDriverBase& driver : _drivers) {
+    response.print(dlm);
+    response.print('"');
+    response.print(driver.getTypeName());
+    response.print('"');
+    dlm = ',';
+  }
+  if (dlm == '[')
+    response.print(dlm);
+  response.print(']');
+}
+
+/**
+ * Responds to the GET request for the REST endpoint with the EdgeData
+ * serialized to JSON. It streams the serializer output directly to the
+ * client without going through the HTML rendering of AutoConnectAux.
+ * @param  typeName Type name of EdgeData given by the path argument.
+ */
+void EdgeUnified::_apiGet(const String& typeName) {
+  EdgeUnifiedNS::WebServer& webServer = server();
+
+  if (!typeName.length()) {
+    _apiList();
+    return;
+  }
+
+  EdgeDriverBase* driver = _findDriver(typeName);
+  if (!driver) {
+    webServer.send(404, "text/plain", typeName + F(" not attached"));
+    return;
+  }
+  if (!driver->_serializer) {
+    webServer.send(501, "text/plain", typeName + F(" has no serializer"));
+    return;
+  }
+
+  ArduinoJsonBuffer doc(driver->_jsonBufferSize);
+  ArduinoJsonObject json = ARDUINOJSON_CREATEOBJECT(doc);
+  driver->_serializer(json);
+  EdgeChunkedResponse response(webServer, 200, PSTR("application/json"));
+  ArduinoJson::serializeJson(json, response);
+}
+
+/**
+ * Applies the JSON body of the PUT request for the REST endpoint to the
+ * EdgeData through the deserializer. If the EdgeDriver is in autoSave, the
+ * applied EdgeData is saved.
+ * @param  typeName Type name of EdgeData given by the path argument.
+ */
+void EdgeUnified::_apiPut(const String& typeName) {
+  EdgeUnifiedNS::WebServer& webServer = server();
+
+  EdgeDriverBase* driver = _findDriver(typeName);
+  if (!driver) {
+    webServer.send(404, "text/plain", typeName + F(" not attached"));
+    return;
+  }
+  if (!driver->_deserializer) {
+    webServer.send(501, "text/plain", typeName + F(" has no deserializer"));
+    return;
+  }
+
+  ArduinoJsonBuffer doc(driver->_jsonBufferSize);
+  const String& body = webServer.arg(F("plain"));
+  DeserializationError  err = ArduinoJson::deserializeJson(doc, body.c_str(), body.length());
+  if (err) {
+    webServer.send(400, "text/plain", String(err.c_str()));
+    return;
+  }
+  JsonObject  json = doc.as<JsonObject>();
+  driver->_deserializer(json);
+  if (driver->isAutoSave())
+    driver->save();
+  webServer.send(204);
+}
+
+/**
+ * Responds the states of the jobs. The job identified by the path argument
+ * is reported as a JSON object, otherwise all the jobs as an array.
+ * @param  idArg  Job identifier given by the path argument, empty for all.
+ */
+void EdgeUnified::_jobsGet(const String& idArg) {
+  EdgeUnifiedNS::WebServer& webServer = server();
+  const uint16_t  id = idArg.length() ? static_cast<uint16_t>(idArg.toInt()) : 0;
+  static const char* const  stateName[] = { "pending", "running", "done" };
+  std::vector<EdgeJob_t>  states;
+
+  _lockJobs();
+  for (const std::pair<uint16_t, int>& jobResult : _jobResults)
+    if (!id || jobResult.first == id)
+      states.push_back({ jobResult.first, nullptr, nullptr, jobResult.second, ED_JOB_DONE });
+  for (const EdgeJob_t& job : _jobs)
+    if (!id || job.id == id)
+      states.push_back({ job.id, nullptr, nullptr, job.result, job.state });
+  _unlockJobs();
+
+  if (id && !states.size()) {
+    webServer.send(404, "text/plain", String(F("Job ")) + idArg + F(" not found"));
+    return;
+  }
+
+  EdgeChunkedResponse response(webServer, 200, PSTR("application/json"));
+  if (!id)
+    response.print('[');
+  for (size_t n = 0; n < states.size(); n++) {
+    if (n)
+      response.print(',');
+    response.printf_P(PSTR("{\"id\":%u,\"state\":\"%s\""), states[n].id, stateName[states[n].state]);
+    if (states[n].state == ED_JOB_DONE)
+      response.printf_P(PSTR(",\"result\":%d"), states[n].result);
+    response.print('}');
+  }
+  if (!id)
+    response.print(']');
+}
+
+/**
+ * Responds the restart history of the supervised EdgeDrivers as a JSON
+ * array in chronological order, followed by the EdgeDrivers waiting for
+ * the restart.
+ */
+void EdgeUnified::_supervisorGet(void) {
+  auto  typeName = [this](const uint16_t id) {
+    for (EdgeDriverBase& driver : _drivers)
+      if (driver._traceId == id)
+        return driver.getTypeName();
+    return String(F("EdgeDriver#")) + String(id);
+  };
+
+  EdgeChunkedResponse response(server(), 200, PSTR("application/json"));
+  const unsigned long now = millis();
+  bool  delimit = false;
+  response.print('[');
+  for (const EdgeRestart_t& restart : _restarts) {
+    if (delimit)
+      response.print(',');
+    delimit = true;
+    response.printf_P(PSTR("{\"driver\":\"%s\",\"tm\":%lu,\"error\":%d,\"failures\":%u,\"state\":\"%s\"}"),
+      typeName(restart.id).c_str(), restart.tm, restart.error, restart.failures, restart.escalated ? "escalated" : "restarted");
+  }
+  for (EdgeDriverBase& driver : _drivers) {
+    if (!driver._restartPending)
+      continue;
+    if (delimit)
+      response.print(',');
+    delimit = true;
+    unsigned long elapsed = now - driver._restartTm;
+    response.printf_P(PSTR("{\"driver\":\"%s\",\"tm\":%lu,\"error\":%d,\"failures\":%u,\"state\":\"pending\",\"in\":%lu}"),
+      driver.getTypeName().c_str(), driver._restartTm, driver._lastError, driver._failures,
+      elapsed < driver._restartDelay ? driver._restartDelay - elapsed : 0UL);
+  }
+  response.print(']');
+}
+
+#ifdef ED_JOB_WORKER_ENABLED
+/**
+ * The worker task that runs the submitted jobs in order. The completed job
+ * stays in the queue until EdgeUnified::process reports it.
+ * @param  edge EdgeUnified instance.
+ */
+void EdgeUnified::_jobWorker(void* edge) {
+  EdgeUnified*  self = static_cast<EdgeUnified*>(edge);
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    for (;;) {
+      EdgeJob_t*  job = nullptr;
+      self->_lockJobs();
+      for (EdgeJob_t& entry : self->_jobs)
+        if (entry.state == ED_JOB_PENDING) {
+          entry.state = ED_JOB_RUNNING;
+          job = &entry;
+          break;
+        }
+      self->_unlockJobs();
+      if (!job)
+        break;
+
+      int result;
+      while ((result = job->job()) == ED_JOB_CONTINUE)
+        vTaskDelay(1);
+      self->_lockJobs();
+      job->result = result;
+      job->state = ED_JOB_DONE;
+      self->_unlockJobs();
+    }
+  }
+}
+#endif
+
+void EdgeUnified::_lockJobs(void) {
+#ifdef ED_JOB_WORKER_ENABLED
+  if (_jobsLock)
+    xSemaphoreTake(_jobsLock, portMAX_DELAY);
+#endif
+}
+
+/**
+ * Calls the job at the head of the queue once, and reports the completed
+ * jobs to their completion callbacks. The completed results are kept for
+ * the status endpoint up to ED_JOB_HISTORY.
+ */
+void EdgeUnified::_runJobs(void) {
+#ifndef ED_JOB_WORKER_ENABLED
+  EdgeJob_t&  head = _jobs.front();
+  head.state = ED_JOB_RUNNING;
+  int result = head.job();
+  if (result == ED_JOB_CONTINUE)
+    return;
+  head.result = result;
+  head.state = ED_JOB_DONE;
+#endif
+
+  for (;;) {
+    _lockJobs();
+    if (!_jobs.size() || _jobs.front().state != ED_JOB_DONE) {
+      _unlockJobs();
+      break;
+    }
+    EdgeJob_t job = _jobs.front();
+    _jobs.pop_front();
+    _jobResults.emplace_back(job.id, job.result);
+    if (_jobResults.size() > ED_JOB_HISTORY)
+      _jobResults.pop_front();
+    _unlockJobs();
+
+    ED_DBG("Job %u done:%d\n", job.id, job.result);
+    if (job.done)
+      job.done(job.id, job.result);
+  }
+}
+
+void EdgeUnified::_unlockJobs(void) {
+#ifdef ED_JOB_WORKER_ENABLED
+  if (_jobsLock)
+    xSemaphoreGive(_jobsLock);
+#endif
+}
+
+/**
+ * Decides the deep sleep of the duty cycle at the end of the turn. The node
+ * stays awake while the jobs, the restarts or the prerequisites are pending
+ * or an EdgeDriver without the interval is running, up to the awake limit
+ * from the time the duty cycle was set or resumed, and while the next due
+ * EdgeDriver is closer than the minimum sleep.
+ */
+void EdgeUnified::_duty(void) {
+  const unsigned long now = millis();
+  bool  pending = _jobs.size() || _restartsPending || _gateChanged;
+  for (EdgeDriverBase& driver : _drivers)
+    pending |= driver._gated || driver._busy();
+  if (pending && now - _dutyTm < _dutyAwakeLimit)
+    return;
+
+  long  wake = _wake(now);
+  if (wake < static_cast<long>(_dutyMinSleep))
+    return;
+  _sleep(wake == LONG_MAX ? ED_DUTY_MAXSLEEP : static_cast<unsigned long>(wake));
+}
+
+/**
+ * Ends the running EdgeDrivers in the reverse order of the dependencies
+ * before the deep sleep. The EdgeDriver that no running EdgeDriver requires
+ * ends first, and the circular dependencies end in the order of the
+ * priority. Each EdgeDriver persists its buffers with the flush callback
+ * just before it ends, and the auto-save EdgeDrivers save EdgeData only if
+ * it has changed.
+ */
+void EdgeUnified::_endOrdered(void) {
+  std::vector<EdgeDriverBase*>  running;
+  for (EdgeDriverBase& driver : _drivers)
+    if (driver._started)
+      running.push_back(&driver);
+
+  auto  required = [&](const EdgeDriverBase* driver) {
+    for (const EdgeDriverBase* other : running) {
+      for (const EdgeRequire& require : other->_requires)
+        if (require.driver == driver)
+          return true;
+      if (std::find(driver->_dependents.begin(), driver->_dependents.end(), other) != driver->_dependents.end())
+        return true;
+    }
+    return false;
+  };
+
+  while (running.size()) {
+    std::vector<EdgeDriverBase*>::iterator  it = std::find_if(running.begin(), running.end(), [&](const EdgeDriverBase* driver) { return !required(driver); });
+    if (it == running.end())
+      it = running.begin();
+    EdgeDriverBase* driver = *it;
+    running.erase(it);
+    if (driver->_cbFlush)
+      driver->_cbFlush();
+    driver->_end(driver->isAutoSave() && driver->isDirty());
+  }
+}
+
+/**
+ * Counts the failure of the supervised EdgeDriver and schedules its restart
+ * with the backoff, or escalates it if the failures within the window
+ * reached the limit of the supervision policy.
+ * @param  driver EdgeDriver stopped by the error.
+ * @param  error  Error code of the failure.
+ */
+void EdgeUnified::_failed(EdgeDriverBase& driver, const int error) {
+  const unsigned long now = millis();
+  if (!driver._failures || now - driver._failureTm >= driver._superviseWindow) {
+    driver._failures = 0;
+    driver._failureTm = now;
+  }
+  if (driver._failures < UINT8_MAX)
+    driver._failures++;
+  driver._lastError = error;
+
+  if (driver._superviseFailures && driver._failures >= driver._superviseFailures) {
+    driver._restartPending = false;
+    _recordRestart(driver, true);
+    ED_DBG("%s escalated, %u failures error:%d\n", driver.getTypeName().c_str(), driver._failures, error);
+    if (_onEscalate)
+      _onEscalate(driver, error);
+    return;
+  }
+
+  unsigned long delay = driver._superviseDelay;
+  for (uint8_t n = 1; n < driver._failures && delay < driver._superviseMaxDelay; n++)
+    delay <<= 1;
+  driver._restartDelay = std::min(delay, driver._superviseMaxDelay);
+  driver._restartTm = now;
+  driver._restartPending = true;
+  _restartsPending = true;
+  ED_DBG("%s restarts in %lu ms, error:%d\n", driver.getTypeName().c_str(), driver._restartDelay, error);
+}
+
+/**
+ * Starts the EdgeDrivers waiting for the prerequisites that hold now, and
+ * ends the EdgeDrivers whose prerequisites no longer hold. An EdgeDriver
+ * started in a pass lets its dependents start in the next pass, so the
+ * EdgeDrivers start in the order of the dependencies. The passes are bounded
+ * by the number of the EdgeDrivers, and the circular dependencies never
+ * start.
+ */
+void EdgeUnified::_gate(void) {
+  _gateChanged = false;
+  bool  changed = true;
+  for (size_t pass = 0; changed && pass <= _drivers.size(); pass++) {
+    changed = false;
+    for (EdgeDriverBase& driver : _drivers) {
+      if (!driver._requires.size())
+        continue;
+      if (driver._gated) {
+        if (driver._ready()) {
+          ED_DBG("%s prerequisites ready\n", driver.getTypeName().c_str());
+          driver.start();
+          changed = true;
+        }
+      }
+      else if (driver._started && !driver._ready()) {
+        ED_DBG("%s prerequisites lost\n", driver.getTypeName().c_str());
+        _hold(driver);
+        changed = true;
+      }
+    }
+  }
+}
+
+/**
+ * Ends the EdgeDriver after its running dependents, and keeps it waiting
+ * for the prerequisites.
+ * @param  driver EdgeDriver to be held.
+ */
+void EdgeUnified::_hold(EdgeDriverBase& driver) {
+  driver._gated = true;
+  for (EdgeDriverBase& dependent : _drivers) {
+    if (!dependent._started || dependent._gated)
+      continue;
+    for (const EdgeRequire& require : dependent._requires)
+      if (require.driver == &driver) {
+        _hold(dependent);
+        break;
+      }
+  }
+  driver.end();
+}
+
+/**
+ * Enters the deep sleep of the duty cycle. The schedules of the EdgeDrivers
+ * and the awake time of the cycle are kept in the RTC memory, then the
+ * EdgeDrivers end with the flush of the changed EdgeData.
+ * @param  sleep  Duration [ms] of the sleep.
+ */
+void EdgeUnified::_sleep(unsigned long sleep) {
+  sleep = std::min(sleep, static_cast<unsigned long>(ED_DUTY_MAXSLEEP));
+#if defined(ARDUINO_ARCH_ESP8266)
+  sleep = std::min(sleep, static_cast<unsigned long>(ESP.deepSleepMax() / 1000));
+#endif
+
+  const unsigned long now = millis();
+  memset(_edgeDutyState.due, 0, sizeof(_edgeDutyState.due));
+  for (EdgeDriverBase& driver : _drivers) {
+    if (!driver._traceId || driver._traceId > ED_DUTY_DRIVERS)
+      continue;
+    // The EdgeDriver not started yet is due at the next wake
+    const bool  resumed = !(_dutyResume & (1UL << (driver._traceId - 1)));
+    _edgeDutyState.due[driver._traceId - 1] = resumed && driver._started ? driver._remain(now) : 0;
+  }
+  _edgeDutyState.drivers = std::min(static_cast<uint32_t>(_traceIds), static_cast<uint32_t>(ED_DUTY_DRIVERS));
+
+  _endOrdered();
+
+  // The schedules advance during the end of the EdgeDrivers
+  const unsigned long awake = millis();
+  for (uint32_t n = 0; n < _edgeDutyState.drivers; n++)
+    _edgeDutyState.due[n] -= awake - now;
+  _edgeDutyState.magic = ED_DUTY_MAGIC;
+  _edgeDutyState.cycles++;
+  _edgeDutyState.awake = awake;
+  _edgeDutyState.awakeTotal += awake;
+  _edgeDutyState.sleep = sleep;
+  _edgeDutyState.digest = _edgeDutyDigest();
+  ED_DBG("Duty cycle %lu, awake %lu ms, sleep %lu ms\n", static_cast<unsigned long>(_edgeDutyState.cycles), awake, sleep);
+#if defined(ED_DEBUG) && ED_DEBUG_DEFERRED
+  EdgeDebugLog.drain(ED_DEBUG_PORT, true);
+#endif
+
+#if defined(ARDUINO_ARCH_ESP8266)
+  ESP.rtcUserMemoryWrite(ED_DUTY_RTCOFFSET, reinterpret_cast<uint32_t*>(&_edgeDutyState), sizeof(_edgeDutyState));
+  ESP.deepSleep(static_cast<uint64_t>(sleep) * 1000);
+#elif defined(ARDUINO_ARCH_ESP32)
+  esp_sleep_enable_timer_wakeup(static_cast<uint64_t>(sleep) * 1000);
+  esp_deep_sleep_start();
+#endif
 }
 
 /**
- * Consecutively calls the process function of the EdgeDrivers bound to the
- * EdgeUnifined to execute an event loop.
+ * Appends a record to the restart history, the oldest record is discarded
+ * beyond ED_SUPERVISOR_HISTORY.
+ * @param  driver     EdgeDriver restarted or escalated.
+ * @param  escalated  The EdgeDriver has been escalated.
  */
-void EdgeUnified::process(void) {
-  // Loop for EdgeDrivers
-  for (EdgeDriverBase& driver : _drivers)
-    driver.process();
+void EdgeUnified::_recordRestart(const EdgeDriverBase& driver, const bool escalated) {
+  _restarts.push_back({ millis(), driver._traceId, driver._lastError, driver._failures, escalated });
+  while (_restarts.size() > ED_SUPERVISOR_HISTORY)
+    _restarts.pop_front();
 }
 
 /**
- * Releases AutoConnectAux with the specified uri from EdgeUnified.
- * @param  uri    Specify the uri of AutoConnectAux to be released from EdgeUnified.
- * @return true   Released AutoConnectAux with specified uri from EdgeUnified.
- * @return false  AutoConnectAux with specified uri is not joined.
+ * Restarts the supervised EdgeDriver. The running dependents registered
+ * with restartWith are ended before the EdgeDriver starts, and only those
+ * are started after it so that they find the EdgeDriver running. The
+ * dependents that the sketch has ended stay ended.
+ * @param  driver EdgeDriver to restart.
  */
-bool EdgeUnified::release(const String& uri) {
-  if (!_portal) {
-    ED_DBG("Releasing %s, AutoConnect not bound\n", uri.c_str());
-    return false;
+void EdgeUnified::_restart(EdgeDriverBase& driver) {
+  std::vector<EdgeDriverBase*>  ended;
+  for (EdgeDriverBase* dependent : driver._dependents)
+    if (dependent->_enable) {
+      dependent->end();
+      ended.push_back(dependent);
+    }
+
+  driver._stats.restarts++;
+  _recordRestart(driver, false);
+  ED_DBG("%s restarting, %u failures\n", driver.getTypeName().c_str(), driver._failures);
+  driver.start();
+
+  for (EdgeDriverBase* dependent : ended)
+    dependent->start();
+}
+
+/**
+ * Takes over the schedule of the EdgeDriver kept over the deep sleep. The
+ * time until due at the sleep is reduced by the sleep, and the EdgeDriver
+ * that has become due runs in the current turn.
+ * @param  driver EdgeDriver started after the wake.
+ */
+void EdgeUnified::_resume(EdgeDriverBase& driver) {
+  if (!driver._traceId || driver._traceId > ED_DUTY_DRIVERS)
+    return;
+  const uint32_t  bit = 1UL << (driver._traceId - 1);
+  if (!(_dutyResume & bit))
+    return;
+  _dutyResume &= ~bit;
+
+  const unsigned long period = driver._retries ? driver._retryTm : driver._interval;
+  const long  due = _edgeDutyState.due[driver._traceId - 1] - static_cast<long>(_edgeDutyState.sleep);
+  driver._tm = millis() + due - period - 1;
+}
+
+/**
+ * Restarts the supervised EdgeDrivers whose delay of the restart has
+ * passed. The EdgeDrivers still waiting keep the supervision pending.
+ */
+void EdgeUnified::_supervise(void) {
+  _restartsPending = false;
+  for (EdgeDriverBase& driver : _drivers) {
+    if (!driver._restartPending)
+      continue;
+    if (millis() - driver._restartTm >= driver._restartDelay)
+      _restart(driver);
+    else
+      _restartsPending = true;
   }
-  return _portal->detach(uri);
 }
 
 /**
- * Restore EdgeDates using EdgeData::restore function of all EdgeDrivers bound
- * to EdgeUnified. If the autoMount argument is set to true, the file system
- * will automatically begin and end as needed.
- * @param  autoMount  If True, the restore function tries to begin the
- * specified file system. It also terminates the file system at the exit of
- * the function.
+ * Finds the earliest end of the slack among the EdgeDrivers with the
+ * period. The EdgeDrivers without the interval run every turn and do not
+ * open the wake slot.
+ * @param  now  Current time [ms].
+ * @return The time [ms] until the next wake slot, it is zero or negative
+ * if the slot is open. LONG_MAX if no EdgeDriver has the period.
  */
-void EdgeUnified::restore(AUTOCONNECT_APPLIED_FILECLASS& fs, const bool autoMount) {
+long EdgeUnified::_wake(const unsigned long now) {
+  long  wake = LONG_MAX;
+  for (EdgeDriverBase& driver : _drivers) {
+    if (!driver._enable || driver._offloaded || !driver._cbProcess)
+      continue;
+    if (!(driver._retries ? driver._retryTm : driver._interval))
+      continue;
+    wake = std::min(wake, driver._remain(now) + static_cast<long>(driver._slack));
+  }
+  return wake;
+}
 
-  if (autoMount) {
-    bool  mounted = AutoConnectFS::_isMounted(&fs);
-    if (!mounted) {
-      if (!fs.begin(AUTOCONNECT_FS_INITIALIZATION)) {
-        ED_DBG("%s mount failed\n", AUTOCONNECT_STRING_DEPLOY(AUTOCONNECT_APPLIED_FILESYSTEM));
-        return;
+/**
+ * Registers the WiFi event handlers that mark the prerequisites to be
+ * evaluated. The handlers are registered once, at the first EdgeDriver
+ * that requires the WiFi connection.
+ */
+void EdgeUnified::_watchWiFi(void) {
+  if (_wifiWatched)
+    return;
+  _wifiWatched = true;
+#if defined(ARDUINO_ARCH_ESP8266)
+  _wifiGotIP = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP&) { _gateChanged = true; });
+  _wifiDisconnected = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected&) { _gateChanged = true; });
+#elif defined(ARDUINO_ARCH_ESP32)
+  // The event task calls it, it only marks the change.
+  WiFi.onEvent([this](WiFiEvent_t, WiFiEventInfo_t) { _gateChanged = true; });
+#endif
+}
+
+/**
+ * Joins or releases the AutoConnectAux pages owned by the EdgeDriver
+ * according to its enable state. EdgeDriverBase calls it every time its
+ * enable state changes or the EdgeDriver starts.
+ * @param  driver EdgeDriver instance that owns the pages.
+ */
+void EdgeUnified::_bindPages(EdgeDriverBase& driver) {
+  ED_HEAP_ACCOUNT(driver._heap);
+  _traceOwner = driver._traceId;
+  if (driver._enable) {
+    driver._pageUris.clear();
+    for (const EdgeAux& page : driver._pages) {
+      AutoConnectAux* aux = _join(page);
+      if (aux)
+        driver._pageUris.push_back(String(aux->uri()));
+    }
+  }
+  else {
+    for (const String& uri : driver._pageUris)
+      release(uri);
+    driver._pageUris.clear();
+  }
+  _traceOwner = 0;
+}
+
+/**
+ * Detaches the AutoConnectAux loaded by the join function from AutoConnect
+ * or removes it from the waiting queue.
+ * @param  aux  AutoConnectAux instance to be detached.
+ * @return true   The AutoConnectAux was detached or removed from the queue.
+ * @return false  The AutoConnectAux was neither joined nor queued.
+ */
+bool EdgeUnified::_detachAux(AutoConnectAux* aux) {
+  std::deque<AutoConnectAux*>::iterator queued = std::find(_auxQueue.begin(), _auxQueue.end(), aux);
+  if (queued != _auxQueue.end()) {
+    _auxQueue.erase(queued);
+    return true;
+  }
+  return _portal ? _portal->detach(String(aux->uri())) : false;
+}
+
+/**
+ * Finds the attached EdgeDriver with the type name of EdgeData.
+ * @param  typeName Type name of EdgeData.
+ * @return A pointer to the EdgeDriver. nullptr if not attached.
+ */
+EdgeDriverBase* EdgeUnified::_findDriver(const String& typeName) {
+  for (EdgeDriverBase& driver : _drivers) {
+    if (driver.getTypeName() == typeName)
+      return &driver;
+  }
+  return nullptr;
+}
+
+/**
+ * Pushes the changed fields of the telemetry of all EdgeDrivers as one event
+ * to the Server-Sent Events connections. If nothing has changed, only the
+ * keep-alive comment is sent every ED_EVENTS_KEEPALIVE.
+ */
+void EdgeUnified::_pushEvents(void) {
+  bool  subscribed = false;
+  for (WiFiClient& client : _eventClients) {
+    if (client.connected())
+      subscribed = true;
+    else if (client)
+      client.stop();
+  }
+  if (!subscribed)
+    return;
+
+  ArduinoJsonBuffer frame(ED_EVENTS_BUFFER_SIZE);
+  ArduinoJsonObject frameJson = ARDUINOJSON_CREATEOBJECT(frame);
+  bool  changed = false;
+
+  for (EdgeDriverBase& driver : _drivers) {
+    EdgeDriverBase::EdgeDataSerializerT reporter = driver._reporter ? driver._reporter : driver._serializer;
+    if (!driver._telemetry || !reporter)
+      continue;
+
+    ArduinoJsonBuffer doc(driver._jsonBufferSize ? driver._jsonBufferSize : ED_SERIALIZE_BUFFER_SIZE);
+    ArduinoJsonObject json = ARDUINOJSON_CREATEOBJECT(doc);
+    reporter(json);
+
+    // Compares each field with the hash of the last pushed value and picks
+    // up only the changed fields.
+    JsonObject  delta;
+    for (JsonPair field : json) {
+      EdgeHash  keyHash;
+      EdgeHash  valueHash;
+      keyHash.print(field.key().c_str());
+      ArduinoJson::serializeJson(field.value(), valueHash);
+
+      std::vector<std::pair<uint32_t, uint32_t>>::iterator  pushed = std::find_if(driver._telemetryHash.begin(), driver._telemetryHash.end(), [&](const std::pair<uint32_t, uint32_t>& hash) {
+        return hash.first == keyHash.value();
+      });
+      if (pushed == driver._telemetryHash.end())
+        driver._telemetryHash.push_back(std::make_pair(keyHash.value(), valueHash.value()));
+      else if (pushed->second != valueHash.value())
+        pushed->second = valueHash.value();
+      else if (!_eventsFull)
+        continue;
+
+      if (delta.isNull())
+        delta = frameJson.createNestedObject(driver.getTypeName());
+      delta[field.key()] = field.value();
+      changed = true;
+    }
+  }
+  _eventsFull = false;
+
+  if (changed) {
+    for (WiFiClient& client : _eventClients) {
+      if (client.connected()) {
+        client.print(F("data: "));
+        ArduinoJson::serializeJson(frameJson, client);
+        client.print(F("\n\n"));
       }
     }
+    _eventsAlive = millis();
+  }
+  else if (millis() - _eventsAlive >= ED_EVENTS_KEEPALIVE) {
+    for (WiFiClient& client : _eventClients) {
+      if (client.connected())
+        client.print(F(":\n\n"));
+    }
+    _eventsAlive = millis();
   }
+}
 
-  for (EdgeDriverBase& driver : _drivers)
-    driver.restore(fs, nullptr);
+/**
+ * Sorts the attached EdgeDrivers in descending order of the priority while
+ * keeping the attached order for the same priority.
+ */
+void EdgeUnified::_prioritize(void) {
+  std::stable_sort(_drivers.begin(), _drivers.end(), [](const EdgeDriverBase& lhs, const EdgeDriverBase& rhs) {
+    return lhs._priority > rhs._priority;
+  });
+}
 
-  if (autoMount)
-    fs.end();
+/**
+ * Calculates the fingerprint of the JSON description of the page with the
+ * FNV-1a hash and the length. The fingerprint allows the join function to
+ * determine that the page has already been loaded without parsing the JSON
+ * description. The length keeps the descriptions of the hash collision
+ * apart unless they are also the same length.
+ * @param  page     EdgeAux that has the JSON description.
+ * @param  jsonFile Opened JSON description file if the page specifies the
+ * `file:` identifier. The file is rewound after the calculation.
+ * @return The fingerprint, a pair of the hash and the length.
+ */
+EdgeUnified::EdgeAuxFingerprintT EdgeUnified::_fingerprint(const EdgeAux& page, File& jsonFile) {
+  uint32_t  hash = 2166136261UL;
+  size_t  length = 0;
+
+  if (jsonFile) {
+    uint8_t buffer[64];
+    size_t  len;
+    while ((len = jsonFile.read(buffer, sizeof(buffer))) > 0) {
+      for (size_t i = 0; i < len; i++)
+        hash = (hash ^ buffer[i]) * 16777619UL;
+      length += len;
+    }
+    jsonFile.seek(0);
+  }
+  else {
+    PGM_P json = page.json ? page.json : reinterpret_cast<PGM_P>(page.json_p);
+    uint8_t c;
+    while ((c = pgm_read_byte(json++))) {
+      hash = (hash ^ c) * 16777619UL;
+      length++;
+    }
+  }
+  return EdgeAuxFingerprintT(hash, length);
 }
 
 /**
- * Save EdgeDates using EdgeData::save function of all EdgeDrivers bound to
- * EdgeUnified. If the autoMount argument is set to true, the file system will
- * automatically begin and end as needed.
- * @param  autoMount  If True, the save function tries to begin the specified
- * file system. It also terminates the file system at the exit of the function.
+ * Loads an AutoConnectAux from the JSON description of the page and joins
+ * it to AutoConnect. The page whose fingerprint matches the joined one is
+ * left as it is, and the parked one is reloaded into its instance.
+ * @param  page   JSON and the request handler pair.
+ * @return A pointer to the joined AutoConnectAux. nullptr if the page could
+ * not be joined.
  */
-void EdgeUnified::save(AUTOCONNECT_APPLIED_FILECLASS& fs, const bool autoMount) {
-  if (autoMount) { 
-    bool  mounted = AutoConnectFS::_isMounted(&fs);
-    if (!mounted) {
-      if (!fs.begin(AUTOCONNECT_FS_INITIALIZATION)) {
-        ED_DBG("%s mount failed\n", AUTOCONNECT_STRING_DEPLOY(AUTOCONNECT_APPLIED_FILESYSTEM));
-        return;
+AutoConnectAux* EdgeUnified::_join(const EdgeAux& page) {
+  ED_BOOT_PHASE(this, "join", _traceOwner);
+  if (!page.json && !page.json_p) {
+    ED_DBG("AutoConnectAux JSON descriptor missing\n");
+    return nullptr;
+  }
+
+  // Determines the input source of the JSON description.
+  // If `PGM_P json` has a File: identifier as prefix, then a JSON description
+  // file is loaded from the stream originating from its opened.
+  File  jsonFile;
+  if (page.json) {
+    const char* jsonIn = page.json;
+    const char* jsonProtocol = ED_AUXJSONPROTOCOL_FILE;
+    int diff = 0;
+    while (!diff && *jsonProtocol)
+      diff = tolower((int)*jsonIn++) - (int)*jsonProtocol++;
+    if (!diff) {
+      jsonFile = AUTOCONNECT_APPLIED_FILESYSTEM.open(jsonIn, "r");
+      if (!jsonFile.available()) {
+        ED_DBG("join %s open failed or empty\n", page.json);
+        return nullptr;
       }
     }
   }
 
-  for (EdgeDriverBase& driver : _drivers)
-    driver.save(fs, nullptr);
+  // An AutoConnectAux that has already been loaded from the same JSON
+  // description needs no parsing, just rebinding the request handler.
+  EdgeAuxFingerprintT fingerprint = _fingerprint(page, jsonFile);
+  AutoConnectAux* aux = nullptr;
+  bool  joined = false;
+  std::map<EdgeAuxFingerprintT, String>::iterator src = _auxSource.find(fingerprint);
+  if (src != _auxSource.end()) {
+    aux = _auxIndex[src->second].aux;
+    if (page.auxHandler)
+      aux->on(page.auxHandler);
+    ED_DBG("%s unchanged\n", src->second.c_str());
+  }
+  else {
+    // A released AutoConnectAux with the same JSON description is reused,
+    // otherwise a new one is allocated. Loading the JSON description into
+    // the reused one restores the values of the elements that have been
+    // changed while it was joined, in place of its elements.
+    std::deque<EdgeAuxEntry_t>::iterator  parked = std::find_if(_auxParked.begin(), _auxParked.end(), [&](const EdgeAuxEntry_t& entry) {
+      return entry.fingerprint == fingerprint;
+    });
+    if (parked != _auxParked.end() && page.auxHandler) {
+      aux = parked->aux;
+      _auxParked.erase(parked);
+      ED_DBG("%s reused\n", aux->uri());
+    }
+    else {
+      aux = _auxPool.create();
+      if (!aux) {
+        ED_DBG("New AutoConnectAux allocation failed\n");
+      }
+    }
 
-  if (autoMount)
-    fs.end();
+    if (aux) {
+      // Loading AutoConnectAux JSON description
+      bool  ldcc = false;
+      if (jsonFile)
+        ldcc = aux->load(jsonFile);
+      else if (page.json)
+        ldcc = aux->load(page.json);
+      else if (page.json_p)
+        ldcc = aux->load(page.json_p);
+      if (!ldcc || !page.auxHandler) {
+        // JSON deserialize error or no handler, ignore AutoCOnnectAux
+        _auxPool.destroy(aux);
+        aux = nullptr;
+      }
+    }
+
+    if (aux) {
+      aux->on(page.auxHandler);
+
+      // Swap the AutoConnectAux that has the same uri with the new one.
+      const String  uri = String(aux->uri());
+      std::map<String, EdgeAuxEntry_t>::iterator  swapped = _auxIndex.find(uri);
+      if (swapped != _auxIndex.end()) {
+        _auxSource.erase(swapped->second.fingerprint);
+        _detachAux(swapped->second.aux);
+        _auxPool.destroy(swapped->second.aux);
+        swapped->second.aux = aux;
+        swapped->second.fingerprint = fingerprint;
+      }
+      else
+        _auxIndex[uri] = { aux, fingerprint };
+      _auxSource[fingerprint] = uri;
+      _joinAux(aux);
+      joined = true;
+    }
+  }
+
+  // Delete instances in `file:` of `PGM_P json` file.
+  if (jsonFile)
+    jsonFile.close();
+
+  // The unchanged page is not counted as joined.
+  if (joined) {
+    ED_TRACE(this, ED_TRACE_JOIN, _traceOwner);
+    _joins++;
+  }
+  return aux;
+}
+
+/**
+ * Joins the AutoConnectAux to AutoConnect. If EdgeUnified does not own the
+ * AutoConnect instance yet, the AutoConnectAux enters the waiting queue.
+ * A page with the same uri that has been joined to AutoConnect outside
+ * EdgeUnified is detached and deleted to avoid the duplicated menu item.
+ * The pages that EdgeUnified owns never reach here with the same uri since
+ * the join swaps them out in advance.
+ * @param  aux  AutoConnectAux instance to be joined.
+ */
+void EdgeUnified::_joinAux(AutoConnectAux* aux) {
+  if (_portal) {
+    AutoConnectAux* hasLoaded = _portal->aux(aux->uri());
+    if (hasLoaded && hasLoaded != aux) {
+      ED_DBG("%s replaces the page loaded outside\n", aux->uri());
+      _portal->detach(hasLoaded->uri());
+      delete hasLoaded;
+    }
+    _portal->join(*aux);
+  }
+  else {
+    _auxQueue.push_back(aux);
+    ED_DBG("%s has entered _auxQueue.\n", aux->uri());
+  }
+}
+
+#if ED_HEAP_ACCOUNTING
+uint8_t EdgeHeapScope::_depth = 0;
+#endif
+
+#if ED_BOOT_PHASES
+/**
+ * Allocates the entries of the phases at the first record.
+ * @return true   The entries are available.
+ */
+bool EdgeBoot::_allocate(void) {
+  if (!_phases)
+    _phases = new(std::nothrow) EdgeBootPhase_t[ED_BOOT_PHASES];
+  return _phases != nullptr;
+}
+
+/**
+ * Begins a phase nested in the phases that have not ended.
+ * @param  phase  Name of the phase.
+ * @param  id     Trace id of the EdgeDriver.
+ * @return Index of the recorded phase to be passed to the end function.
+ * ED_BOOT_PHASES if the phase is not recorded.
+ */
+size_t EdgeBoot::begin(PGM_P phase, const uint16_t id) {
+  if (_finished || _count >= ED_BOOT_PHASES || !_allocate())
+    return ED_BOOT_PHASES;
+  EdgeBootPhase_t&  entry = _phases[_count];
+  entry.phase = phase;
+  entry.id = id;
+  entry.depth = _depth++;
+  entry.begin = entry.end = micros();
+  return _count++;
+}
+
+/**
+ * Ends the phase.
+ * @param  index  Index that the begin function returned.
+ */
+void EdgeBoot::end(const size_t index) {
+  if (index < ED_BOOT_PHASES) {
+    _phases[index].end = micros();
+    _depth--;
+  }
+}
+
+/**
+ * Records a mark unless the same mark has been recorded.
+ * @param  phase  Name of the milestone.
+ * @param  id     Trace id of the EdgeDriver.
+ */
+void EdgeBoot::mark(PGM_P phase, const uint16_t id) {
+  for (size_t n = 0; n < _count; n++)
+    if (_phases[n].phase == phase && _phases[n].id == id)
+      return;
+  if (_count < ED_BOOT_PHASES && _allocate()) {
+    EdgeBootPhase_t&  entry = _phases[_count++];
+    entry.phase = phase;
+    entry.id = id;
+    entry.depth = 0;
+    entry.begin = entry.end = micros();
+  }
+}
+
+/**
+ * Outputs the recorded phases.
+ * @param  out    Output destination.
+ * @param  nameOf Returns the name of the EdgeDriver with the trace id.
+ * @return The size of the output.
+ */
+size_t EdgeBoot::report(Print& out, std::function<String(uint16_t)> nameOf) {
+  char  num[24];
+  size_t  len = out.print(F("     begin[us]   duration[us]  phase\n"));
+
+  for (size_t n = 0; n < _count; n++) {
+    const EdgeBootPhase_t&  entry = _phases[n];
+    snprintf(num, sizeof(num), "%14lu ", static_cast<unsigned long>(entry.begin));
+    len += out.print(num);
+    snprintf(num, sizeof(num), "%14lu  ", static_cast<unsigned long>(entry.end - entry.begin));
+    len += out.print(num);
+    for (uint8_t depth = 0; depth < entry.depth; depth++)
+      len += out.print(F("  "));
+    len += out.print(FPSTR(entry.phase));
+    if (entry.id) {
+      len += out.print(' ');
+      len += out.print(nameOf(entry.id));
+    }
+    len += out.print('\n');
+  }
+
+  if (_count >= ED_BOOT_PHASES)
+    len += out.print(F("ED_BOOT_PHASES exhausted\n"));
+  if (_finished) {
+    snprintf(num, sizeof(num), "%lu", static_cast<unsigned long>(_completed));
+    len += out.print(F("boot completed at "));
+    len += out.print(num);
+    len += out.print(F(" us\n"));
+  }
+  return len;
+}
+#endif
+
+#if defined(ED_DEBUG) && ED_DEBUG_DEFERRED
+static_assert(!(ED_DEBUG_RING_SIZE & (ED_DEBUG_RING_SIZE - 1)), "ED_DEBUG_RING_SIZE must be a power of 2");
+static_assert(ED_DEBUG_ARGS_SIZE <= 255 && ED_DEBUG_ARGS_SIZE + 11 <= ED_DEBUG_LINE_SIZE, "ED_DEBUG_ARGS_SIZE does not fit in ED_DEBUG_LINE_SIZE");
+
+/**
+ * Stores a record of the format string and the arguments.
+ * @param  fmt  Format string in PROGMEM.
+ * @param  args Arguments of the format string.
+ */
+void EdgeLog::log(PGM_P fmt, va_list args) {
+  uint32_t  pos;
+  EdgeLogRecord_t*  rec = _reserve(pos);
+  if (rec) {
+    rec->fmt = fmt;
+    rec->tm = micros();
+    rec->args.clear();
+    rec->args.pack(fmt, args);
+    _commit(rec, pos);
+  }
+}
+
+/**
+ * Writes out the deferred records to the output. Without blocking, it
+ * writes only within the free space of the output buffer, and the rest of
+ * the record being written is carried over to the next call.
+ * @param  out    Output destination.
+ * @param  block  Writes out all the records even if the output blocks.
+ * @return Number of the bytes written.
+ */
+size_t EdgeLog::drain(Print& out, const bool block) {
+  size_t  written = 0;
+
+  for (;;) {
+    if (_linePos >= _lineLen && !_fetch())
+      break;
+    size_t  len = _lineLen - _linePos;
+    if (!block) {
+      int room = out.availableForWrite();
+      if (room <= 0)
+        break;
+      len = std::min(len, static_cast<size_t>(room));
+    }
+    size_t  n = out.write(reinterpret_cast<const uint8_t*>(_line) + _linePos, len);
+    if (!n)
+      break;
+    _linePos += n;
+    written += n;
+  }
+  return written;
+}
+
+/**
+ * Takes the next record out of the ring buffer into the line buffer. The
+ * drops that occurred since the last report precede the record as a record
+ * of their own.
+ * @return true   The line buffer has the next record.
+ * @return false  No record remains.
+ */
+bool EdgeLog::_fetch(void) {
+  _linePos = 0;
+  _lineLen = 0;
+
+  uint32_t  drops = _drops.load(std::memory_order_relaxed);
+  if (drops != _dropsReported) {
+    EdgeLogRecord_t rec;
+    rec.fmt = PSTR("[ED] %u debug records dropped\n");
+    rec.tm = micros();
+    rec.args.clear();
+    uint32_t  count = drops - _dropsReported;
+    rec.args.store(&count, sizeof(count));
+    _dropsReported = drops;
+    _lineLen = ED_DEBUG_DEFERRED == 2 ? _frame(rec) : _format(rec);
+    return true;
+  }
+
+  const uint32_t  pos = _tail;
+  const uint32_t  index = pos & (ED_DEBUG_RING_SIZE - 1);
+  EdgeLogRecord_t&  rec = _ring[index];
+  if (rec.seq.load(std::memory_order_acquire) + index != pos + 1)
+    return false;
+  _lineLen = ED_DEBUG_DEFERRED == 2 ? _frame(rec) : _format(rec);
+  rec.seq.store(pos + ED_DEBUG_RING_SIZE - index, std::memory_order_release);
+  _tail = pos + 1;
+  return true;
+}
+
+/**
+ * Reserves a slot of the ring buffer for a record. The sequence of the slot
+ * tells whether the slot is free for the position, so the producers compete
+ * only for the head of the ring.
+ * @param  pos  Receives the position of the reserved slot.
+ * @return The reserved slot. nullptr if the ring is full.
+ */
+EdgeLog::EdgeLogRecord_t* EdgeLog::_reserve(uint32_t& pos) {
+#if defined(ARDUINO_ARCH_ESP8266)
+  // The single core competes only with the interrupts, which are masked
+  // while reserving the slot.
+  uint32_t  ps = xt_rsil(15);
+  pos = _head.load(std::memory_order_relaxed);
+  EdgeLogRecord_t*  rec = &_ring[pos & (ED_DEBUG_RING_SIZE - 1)];
+  if (rec->seq.load(std::memory_order_relaxed) + (pos & (ED_DEBUG_RING_SIZE - 1)) == pos)
+    _head.store(pos + 1, std::memory_order_relaxed);
+  else {
+    _drops.store(_drops.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    rec = nullptr;
+  }
+  xt_wsr_ps(ps);
+  return rec;
+#else
+  pos = _head.load(std::memory_order_relaxed);
+  for (;;) {
+    EdgeLogRecord_t*  rec = &_ring[pos & (ED_DEBUG_RING_SIZE - 1)];
+    int32_t dif = static_cast<int32_t>(rec->seq.load(std::memory_order_acquire) + (pos & (ED_DEBUG_RING_SIZE - 1)) - pos);
+    if (!dif) {
+      if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        return rec;
+    }
+    else if (dif < 0) {
+      _drops.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    else
+      pos = _head.load(std::memory_order_relaxed);
+  }
+#endif
+}
+
+/**
+ * Hands over the stored record to the drain.
+ * @param  rec  Reserved slot.
+ * @param  pos  Position of the slot.
+ */
+void EdgeLog::_commit(EdgeLogRecord_t* rec, const uint32_t pos) {
+  rec->seq.store(pos + 1 - (pos & (ED_DEBUG_RING_SIZE - 1)), std::memory_order_release);
+}
+
+/**
+ * Formats the record into the line buffer with the format string. Each
+ * conversion specification takes the stored argument of the size that it
+ * implies, which is the same size as the log function stored.
+ * @param  rec  Record.
+ * @return Length of the formatted line.
+ */
+size_t EdgeLog::_format(const EdgeLogRecord_t& rec) {
+  return rec.args.format(_line, sizeof(_line), rec.fmt);
+}
+
+/**
+ * Builds the binary frame of the record into the line buffer. The frame
+ * consists of the sync byte 0xED, the truncated flag, the size of the
+ * arguments, the time, the address of the format string and the arguments
+ * in little-endian.
+ * @param  rec  Record.
+ * @return Size of the frame.
+ */
+size_t EdgeLog::_frame(const EdgeLogRecord_t& rec) {
+  uint8_t*  frame = reinterpret_cast<uint8_t*>(_line);
+  uint32_t  fmt = reinterpret_cast<uintptr_t>(rec.fmt);
+
+  frame[0] = 0xed;
+  frame[1] = rec.args.truncated() ? 1 : 0;
+  frame[2] = rec.args.length();
+  memcpy(frame + 3, &rec.tm, sizeof(rec.tm));
+  memcpy(frame + 7, &fmt, sizeof(fmt));
+  memcpy(frame + 11, rec.args.data(), rec.args.length());
+  return 11 + rec.args.length();
+}
+#endif
+
+/**
+ * Stores the debug output of ED_DBG with ED_DEBUG_DEFERRED into the deferred
+ * records. If EdgeUnified.cpp was built without the deferral, the output is
+ * printed to ED_DEBUG_PORT at the call instead.
+ * @param  fmt  Format string in PROGMEM.
+ */
+void EdgeDebugDeferred(PGM_P fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+#if defined(ED_DEBUG) && ED_DEBUG_DEFERRED
+  EdgeDebugLog.log(fmt, args);
+#else
+  char  line[ED_DEBUG_LINE_SIZE];
+  vsnprintf_P(line, sizeof(line), fmt, args);
+  ED_DEBUG_PORT.print(line);
+#endif
+  va_end(args);
 }
 
 // Export an EdgeUnified instance as an Edge to the global.
@@ -10,8 +10,12 @@
 #ifndef _EDGEUNIFIED_H_
 #define _EDGEUNIFIED_H_
 
+#include <atomic>
+#include <climits>
 #include <deque>
 #include <functional>
+#include <map>
+#include <type_traits>
 #include <vector>
 #include <Arduino.h>
 #if defined(ARDUINO_ARCH_ESP8266)
@@ -21,8 +25,10 @@ namespace EdgeUnifiedNS { using WebServer = ESP8266WebServer; };
 #include <WebServer.h>
 namespace EdgeUnifiedNS { using WebServer = WebServer; };
 #endif
+#include <uri/UriBraces.h>
 #include <ArduinoJson.h>
 #include <AutoConnect.h>
+#include "EdgeBlockPool.h"
 
 // Uncomment the following ED_DEBUG to enable debug output.
 //#define ED_DEBUG
@@ -32,7 +38,34 @@ namespace EdgeUnifiedNS { using WebServer = WebServer; };
 #define ED_DEBUG_PORT Serial
 #endif // !ED_DEBUG_PORT
 
-#ifdef ED_DEBUG
+// ED_DEBUG_DEFERRED defers the debug output to EdgeUnified::process instead
+// of printing it at ED_DBG. 1 formats the deferred records on the device,
+// and 2 writes them as the binary frames for extras/edlogdecode.py.
+#ifndef ED_DEBUG_DEFERRED
+#define ED_DEBUG_DEFERRED                     0
+#endif // !ED_DEBUG_DEFERRED
+
+// Number of the deferred records that the ring buffer holds. It must be a
+// power of 2.
+#ifndef ED_DEBUG_RING_SIZE
+#define ED_DEBUG_RING_SIZE                    32
+#endif // !ED_DEBUG_RING_SIZE
+
+// Size of the arguments stored in a deferred record. The arguments beyond it
+// are truncated.
+#ifndef ED_DEBUG_ARGS_SIZE
+#define ED_DEBUG_ARGS_SIZE                    32
+#endif // !ED_DEBUG_ARGS_SIZE
+
+// Size of the buffer that holds a formatted record until it is written out.
+#ifndef ED_DEBUG_LINE_SIZE
+#define ED_DEBUG_LINE_SIZE                    128
+#endif // !ED_DEBUG_LINE_SIZE
+
+#if defined(ED_DEBUG) && ED_DEBUG_DEFERRED
+#define ED_DBG_DUMB(fmt, ...) do {EdgeDebugDeferred((PGM_P)PSTR(fmt), ## __VA_ARGS__ );} while (0)
+#define ED_DBG(fmt, ...) do {EdgeDebugDeferred((PGM_P)PSTR("[ED] " fmt), ## __VA_ARGS__ );} while (0)
+#elif defined(ED_DEBUG)
 #define ED_DBG_DUMB(fmt, ...) do {ED_DEBUG_PORT.printf_P((PGM_P)PSTR(fmt), ## __VA_ARGS__ );} while (0)
 #define ED_DBG(fmt, ...) do {ED_DEBUG_PORT.printf_P((PGM_P)PSTR("[ED] " fmt), ## __VA_ARGS__ );} while (0)
 #else
@@ -40,6 +73,14 @@ namespace EdgeUnifiedNS { using WebServer = WebServer; };
 #define ED_DBG_DUMB(...) do {(void)0;} while(0)
 #endif // !ED_DEBUG
 
+/**
+ * Backend of ED_DBG with ED_DEBUG_DEFERRED. It is defined in EdgeUnified.cpp
+ * regardless of the debug macros, so the sketch and the EdgeDrivers in the
+ * headers can defer the debug output even if EdgeUnified.cpp was built
+ * without it. In that case the output is printed at the call.
+ */
+void  EdgeDebugDeferred(PGM_P fmt, ...);
+
 // ED_SERIALIZE_BUFFER_SIZE is the allocation size for the area of the
 // DynamicJsonDocument for ArduinoJson used to achieve serialization
 // and deserialization of EdgeData in JSON format.
@@ -70,11 +111,241 @@ namespace EdgeUnifiedNS { using WebServer = WebServer; };
 #define ED_GETTYPE_TERMINATOR                 ';'
 #endif // !ED_GETTYPE_TERMINATOR
 
+// Path of the REST endpoint that EdgeUnified::api serves EdgeData on. The
+// EdgeData of each EdgeDriver is accessed with its type name as the subpath.
+#ifndef ED_API_PATH
+#define ED_API_PATH                           "/edge/api"
+#endif // !ED_API_PATH
+
+// Size of the buffer that accumulates a chunk of the chunked HTTP response.
+#ifndef ED_CHUNK_BUFFER_SIZE
+#define ED_CHUNK_BUFFER_SIZE                  128
+#endif // !ED_CHUNK_BUFFER_SIZE
+
+// Path of the Server-Sent Events endpoint that EdgeUnified::events serves
+// the telemetry of EdgeDrivers on.
+#ifndef ED_EVENTS_PATH
+#define ED_EVENTS_PATH                        "/edge/events"
+#endif // !ED_EVENTS_PATH
+
+// Maximum number of the Server-Sent Events connections kept by EdgeUnified.
+#ifndef ED_EVENTS_MAX_CLIENTS
+#define ED_EVENTS_MAX_CLIENTS                 4
+#endif // !ED_EVENTS_MAX_CLIENTS
+
+// Default minimum interval [ms] between the telemetry events.
+#ifndef ED_EVENTS_INTERVAL
+#define ED_EVENTS_INTERVAL                    1000
+#endif // !ED_EVENTS_INTERVAL
+
+// Interval [ms] of the keep-alive comment sent while no telemetry changes.
+#ifndef ED_EVENTS_KEEPALIVE
+#define ED_EVENTS_KEEPALIVE                   15000
+#endif // !ED_EVENTS_KEEPALIVE
+
+// Allocation size of the DynamicJsonDocument that batches the telemetry of
+// all EdgeDrivers into one event.
+#ifndef ED_EVENTS_BUFFER_SIZE
+#define ED_EVENTS_BUFFER_SIZE                 512
+#endif // !ED_EVENTS_BUFFER_SIZE
+
+// Resolution [bits] of the LEDC duty for the PWM offload on ESP32. The
+// higher resolution lowers the minimum frequency LEDC can generate.
+#ifndef ED_OFFLOAD_LEDC_RESOLUTION
+#define ED_OFFLOAD_LEDC_RESOLUTION            13
+#endif // !ED_OFFLOAD_LEDC_RESOLUTION
+
+// Number of the lifecycle events the trace ring buffer holds. It must be a
+// power of 2, and 0 removes the trace from the build. Only EdgeUnified.cpp
+// evaluates it, so it should be given with the build flags.
+#ifndef ED_TRACE_SIZE
+#define ED_TRACE_SIZE                         0
+#endif // !ED_TRACE_SIZE
+
+// Path of the trace endpoint registered by EdgeUnified::trace.
+#ifndef ED_TRACE_PATH
+#define ED_TRACE_PATH                         "/edge/trace"
+#endif // !ED_TRACE_PATH
+
+// Number of the boot phases that the boot timeline records. 0 removes the
+// boot timeline from the build. Only EdgeUnified.cpp evaluates it, so it
+// should be given with the build flags.
+#ifndef ED_BOOT_PHASES
+#define ED_BOOT_PHASES                        0
+#endif // !ED_BOOT_PHASES
+
+// Path of the boot report endpoint registered by EdgeUnified::boot.
+#ifndef ED_BOOT_PATH
+#define ED_BOOT_PATH                          "/edge/boot"
+#endif // !ED_BOOT_PATH
+
+// Attributes the heap consumed in the callbacks, the persistence and the
+// page joins of each EdgeDriver to the EdgeDriver by the change of the free
+// heap across them. 0 removes the accounting from the build.
+#ifndef ED_HEAP_ACCOUNTING
+#define ED_HEAP_ACCOUNTING                    0
+#endif // !ED_HEAP_ACCOUNTING
+
+// Defining ED_DRIVER_RAM_BUDGET [bytes] fails the build of the sketch that
+// attaches an EdgeDriver class larger than it. ED_RAM_BUDGET declares the
+// budget of an individual EdgeDriver class.
+//#define ED_DRIVER_RAM_BUDGET                  512
+#define ED_RAM_BUDGET(type, bytes)            static_assert(sizeof(type) <= (bytes), #type " exceeds its RAM budget")
+
+// Path of the metrics endpoint registered by EdgeUnified::metrics.
+#ifndef ED_METRICS_PATH
+#define ED_METRICS_PATH                       "/metrics"
+#endif // !ED_METRICS_PATH
+
+// Default budget [us] of an EdgeDriver::process call. The call exceeding the
+// budget is counted as an overrun, and 0 disables the budget.
+#ifndef ED_BUDGET_DEFAULT
+#define ED_BUDGET_DEFAULT                     0
+#endif // !ED_BUDGET_DEFAULT
+
+// Default thresholds of the overrun watchdog. The EdgeDriver whose process
+// calls exceed the budget consecutively is demoted every ED_WATCHDOG_DEMOTE
+// overruns, and stopped with ED_ERROR_OVERRUN at ED_WATCHDOG_LIMIT overruns.
+// 0 disables each.
+#ifndef ED_WATCHDOG_DEMOTE
+#define ED_WATCHDOG_DEMOTE                    3
+#endif // !ED_WATCHDOG_DEMOTE
+#ifndef ED_WATCHDOG_LIMIT
+#define ED_WATCHDOG_LIMIT                     10
+#endif // !ED_WATCHDOG_LIMIT
+
+// Interval [ms] given to the demoted EdgeDriver that had no interval, and
+// the maximum interval [ms] to which the demotions double it.
+#ifndef ED_WATCHDOG_INTERVAL
+#define ED_WATCHDOG_INTERVAL                  100
+#endif // !ED_WATCHDOG_INTERVAL
+#ifndef ED_WATCHDOG_MAXINTERVAL
+#define ED_WATCHDOG_MAXINTERVAL               60000
+#endif // !ED_WATCHDOG_MAXINTERVAL
+
+// The error code with which the watchdog stops the EdgeDriver.
+#define ED_ERROR_OVERRUN                      (INT_MIN + 1)
+
+// Default supervision policy of EdgeDriverBase::supervise. The initial and
+// the maximum delay [ms] of the restart, the number of the failures within
+// the window [ms] that escalates instead of restarting, and the number of
+// the restarts kept in the history.
+#ifndef ED_SUPERVISOR_MAXDELAY
+#define ED_SUPERVISOR_MAXDELAY                60000
+#endif // !ED_SUPERVISOR_MAXDELAY
+#ifndef ED_SUPERVISOR_FAILURES
+#define ED_SUPERVISOR_FAILURES                5
+#endif // !ED_SUPERVISOR_FAILURES
+#ifndef ED_SUPERVISOR_WINDOW
+#define ED_SUPERVISOR_WINDOW                  600000
+#endif // !ED_SUPERVISOR_WINDOW
+#ifndef ED_SUPERVISOR_HISTORY
+#define ED_SUPERVISOR_HISTORY                 8
+#endif // !ED_SUPERVISOR_HISTORY
+
+// Path of the restart history endpoint registered by EdgeUnified::supervisor.
+#ifndef ED_SUPERVISOR_PATH
+#define ED_SUPERVISOR_PATH                    "/edge/supervisor"
+#endif // !ED_SUPERVISOR_PATH
+
+// Duty-cycle mode of EdgeUnified::dutyCycle. The shortest sleep [ms] worth
+// entering the deep sleep, the longest sleep [ms], and the limit [ms] of the
+// awake time waiting for the pending jobs and prerequisites.
+#ifndef ED_DUTY_MINSLEEP
+#define ED_DUTY_MINSLEEP                      1000
+#endif // !ED_DUTY_MINSLEEP
+#ifndef ED_DUTY_MAXSLEEP
+#define ED_DUTY_MAXSLEEP                      3600000
+#endif // !ED_DUTY_MAXSLEEP
+#ifndef ED_DUTY_AWAKELIMIT
+#define ED_DUTY_AWAKELIMIT                    30000
+#endif // !ED_DUTY_AWAKELIMIT
+
+// Number of the EdgeDrivers whose schedule is kept over the deep sleep, up
+// to 32, and the offset of the state in the RTC user memory of ESP8266 by
+// the 4-byte block.
+#ifndef ED_DUTY_DRIVERS
+#define ED_DUTY_DRIVERS                       16
+#endif // !ED_DUTY_DRIVERS
+#ifndef ED_DUTY_RTCOFFSET
+#define ED_DUTY_RTCOFFSET                     32
+#endif // !ED_DUTY_RTCOFFSET
+
+// Path of the job status endpoint registered by EdgeUnified::jobs.
+#ifndef ED_JOBS_PATH
+#define ED_JOBS_PATH                          "/edge/jobs"
+#endif // !ED_JOBS_PATH
+
+// Maximum number of the jobs waiting for completion, and the number of the
+// completed job results kept for the status endpoint.
+#ifndef ED_JOB_QUEUE_SIZE
+#define ED_JOB_QUEUE_SIZE                     4
+#endif // !ED_JOB_QUEUE_SIZE
+#ifndef ED_JOB_HISTORY
+#define ED_JOB_HISTORY                        4
+#endif // !ED_JOB_HISTORY
+
+// Runs the submitted jobs on a worker task instead of the slices of
+// EdgeUnified::process. It is available on ESP32 only. Only EdgeUnified.cpp
+// evaluates it, so it should be given with the build flags.
+#ifndef ED_JOB_WORKER
+#define ED_JOB_WORKER                         0
+#endif // !ED_JOB_WORKER
+#ifndef ED_JOB_WORKER_STACK
+#define ED_JOB_WORKER_STACK                   4096
+#endif // !ED_JOB_WORKER_STACK
+#ifndef ED_JOB_WORKER_PRIORITY
+#define ED_JOB_WORKER_PRIORITY                1
+#endif // !ED_JOB_WORKER_PRIORITY
+
+// The return value of the job that asks to be called again in the next turn.
+#define ED_JOB_CONTINUE                       INT_MIN
+
+// Default priority of EdgeDriver. EdgeUnified::process calls the EdgeDrivers
+// in descending order of the priority.
+#ifndef ED_PRIORITY_DEFAULT
+#define ED_PRIORITY_DEFAULT                   128
+#endif // !ED_PRIORITY_DEFAULT
+
+// Default slack [ms] by which EdgeUnified may run the EdgeDriver::process
+// earlier or later than its interval to share the wakeup with the other
+// EdgeDrivers.
+#ifndef ED_SLACK_DEFAULT
+#define ED_SLACK_DEFAULT                      0
+#endif // !ED_SLACK_DEFAULT
+
+// Default retry policy of EdgeDriverBase::retryLater. The initial delay [ms],
+// the maximum delay [ms] and the maximum number of the attempts. Zero attempts
+// means that the retry continues until it succeeds.
+#ifndef ED_RETRY_DELAY
+#define ED_RETRY_DELAY                        1000
+#endif // !ED_RETRY_DELAY
+#ifndef ED_RETRY_MAXDELAY
+#define ED_RETRY_MAXDELAY                     60000
+#endif // !ED_RETRY_MAXDELAY
+#ifndef ED_RETRY_ATTEMPTS
+#define ED_RETRY_ATTEMPTS                     0
+#endif // !ED_RETRY_ATTEMPTS
+
 //
 #ifndef ED_AUXJSONPROTOCOL_FILE
 #define ED_AUXJSONPROTOCOL_FILE               "file:"
 #endif // !ED_AUXJSONPROTOCOL_FILE
 
+// Number of AutoConnectAux blocks that EdgeAuxPool reserves in one piece of
+// the heap. AutoConnectAux instances beyond this number are allocated from
+// the heap individually. The maximum value is 32.
+#ifndef ED_AUXPOOL_BLOCKS
+#define ED_AUXPOOL_BLOCKS                     8
+#endif // !ED_AUXPOOL_BLOCKS
+
+// Number of released AutoConnectAux that EdgeUnified keeps loaded for reuse
+// by the next join with the same JSON description. Specifying 0 deletes the
+// AutoConnectAux immediately at the release.
+#ifndef ED_AUXPOOL_PARKS
+#define ED_AUXPOOL_PARKS                      4
+#endif // !ED_AUXPOOL_PARKS
+
 /**
  * EdgeAux: Combines a JSON description of a custom web page interpreted
  * by AutoConnect with its request handler. EdgeUnifined::join function
@@ -100,14 +371,212 @@ class EdgeAux {
   AuxHandlerFunctionT auxHandler;                       /**< AutoConnectAux request handler */
 };
 
+/**
+ * EdgeAuxPool: Fixed block pool for AutoConnectAux instances created by
+ * EdgeUnified::join. It reserves the blocks for ED_AUXPOOL_BLOCKS instances
+ * in one piece at the first allocation and recycles them, so that repeated
+ * join and release do not fragment the heap.
+ */
+class EdgeAuxPool : public EdgeBlockPool<AutoConnectAux> {
+ public:
+  EdgeAuxPool();
+  ~EdgeAuxPool() {}
+
+  AutoConnectAux* create(void);
+};
+
+/**
+ * EdgeChunkedResponse: Print class that sends its output as the chunks of
+ * the HTTP response with unknown content length. It allows the serializers
+ * to stream the response body to the client without building a String.
+ */
+class EdgeChunkedResponse : public Print {
+ public:
+  EdgeChunkedResponse(EdgeUnifiedNS::WebServer& server, const int code, PGM_P contentType);
+  ~EdgeChunkedResponse() { end(); }
+
+  void  end(void);
+  size_t  write(uint8_t c) override;
+  size_t  write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+
+ protected:
+  void  _flush(void);
+
+  EdgeUnifiedNS::WebServer& _server;                    /**< WebServer that responds */
+  char    _buffer[ED_CHUNK_BUFFER_SIZE];                /**< Chunk buffer */
+  size_t  _len = 0;                                     /**< Length of the buffered chunk */
+  bool    _ended = false;                               /**< The response has been terminated */
+};
+
+/**
+ * EdgeHash: Print class that calculates the FNV-1a hash of its output. It
+ * detects changes of serialized values without keeping their copies.
+ */
+class EdgeHash : public Print {
+ public:
+  EdgeHash() {}
+  ~EdgeHash() {}
+
+  uint32_t  value(void) const { return _hash; }
+  size_t  write(uint8_t c) override { _hash = (_hash ^ c) * 16777619UL; return 1; }
+  using Print::write;
+
+ protected:
+  uint32_t  _hash = 2166136261UL;                       /**< Hash value */
+};
+
+/**
+ * EdgeTrace: Ring buffer of the lifecycle events of the EdgeDrivers with
+ * the timestamp in microseconds. Recording an event is a store of 8 bytes,
+ * and the oldest events are overwritten. The dump function exports the
+ * events in the Chrome trace JSON format that Perfetto opens.
+ * The ring of ED_TRACE_SIZE events is allocated at the first record, so the
+ * class layout does not depend on ED_TRACE_SIZE which only EdgeUnified.cpp
+ * evaluates.
+ */
+class EdgeTrace {
+ public:
+  typedef enum {
+    ED_TRACE_ATTACH,
+    ED_TRACE_START,
+    ED_TRACE_PROCESS_BEGIN,
+    ED_TRACE_PROCESS_END,
+    ED_TRACE_END,
+    ED_TRACE_ERROR,
+    ED_TRACE_SAVE,
+    ED_TRACE_RESTORE,
+    ED_TRACE_JOIN,
+    ED_TRACE_RELEASE
+  } EdgeTraceEvent_t;
+
+  EdgeTrace() {}
+  ~EdgeTrace() { delete[] _ring; }
+
+  void  record(const EdgeTraceEvent_t event, const uint16_t id);
+  size_t  dump(Print& out, std::function<String(uint16_t)> nameOf);
+
+ protected:
+  typedef struct {
+    uint32_t  tm;                                       /**< Time of the event [us] */
+    uint16_t  id;                                       /**< Trace id of the EdgeDriver, 0 is EdgeUnified */
+    uint8_t event;                                      /**< EdgeTraceEvent_t */
+  } EdgeTraceEntry_t;
+
+  EdgeTraceEntry_t* _ring = nullptr;                    /**< Recorded events */
+  uint32_t  _head = 0;                                  /**< Count of the recorded events */
+  bool  _enable = true;                                 /**< Recording is enabled */
+};
+
+/**
+ * EdgeBoot: Timeline of the boot phases in microseconds since the reset.
+ * The phases such as the file system mount, the restoration and the start
+ * of each EdgeDriver, the join of each page and the first turn of the
+ * EdgeUnified::process are recorded until the first turn completes. The
+ * marks are instants that the sketch or the EdgeDrivers place at their
+ * milestones, such as the first publish, even after the boot completed.
+ * The ED_BOOT_PHASES entries are allocated at the first record, so the
+ * class layout does not depend on ED_BOOT_PHASES which only EdgeUnified.cpp
+ * evaluates.
+ */
+class EdgeBoot {
+ public:
+  EdgeBoot() {}
+  ~EdgeBoot() { delete[] _phases; }
+
+  size_t  begin(PGM_P phase, const uint16_t id);
+  void  end(const size_t index);
+  void  finish(void) { _finished = true; _completed = micros(); }
+  bool  finished(void) const { return _finished; }
+  void  mark(PGM_P phase, const uint16_t id);
+  size_t  report(Print& out, std::function<String(uint16_t)> nameOf);
+
+ protected:
+  typedef struct {
+    PGM_P phase;                                        /**< Name of the phase */
+    uint16_t  id;                                       /**< Trace id of the EdgeDriver, 0 is EdgeUnified */
+    uint8_t depth;                                      /**< Nesting level of the phase */
+    uint32_t  begin;                                    /**< Time when the phase began [us] */
+    uint32_t  end;                                      /**< Time when the phase ended [us] */
+  } EdgeBootPhase_t;
+
+  bool  _allocate(void);
+
+  EdgeBootPhase_t*  _phases = nullptr;                  /**< Recorded phases */
+  size_t  _count = 0;                                   /**< Number of the recorded phases */
+  uint8_t _depth = 0;                                   /**< Nesting level of the next phase */
+  bool  _finished = false;                              /**< The first turn of the process completed */
+  uint32_t  _completed = 0;                             /**< Time when the boot completed [us] */
+};
+
+#if ED_HEAP_ACCOUNTING
+/**
+ * EdgeHeapScope: Adds the heap consumed during the scope to the account.
+ * Only the outermost scope measures, so the persistence that an EdgeDriver
+ * callback calls is not counted twice.
+ */
+class EdgeHeapScope {
+ public:
+  explicit EdgeHeapScope(int32_t& account) : _account(account), _outermost(!_depth++) {
+    if (_outermost)
+      _free = ESP.getFreeHeap();
+  }
+  ~EdgeHeapScope() {
+    if (_outermost)
+      _account += static_cast<int32_t>(_free - ESP.getFreeHeap());
+    _depth--;
+  }
+
+ protected:
+  int32_t&  _account;                                   /**< Heap consumed by the EdgeDriver */
+  bool  _outermost;                                     /**< The scope is not nested */
+  uint32_t  _free = 0;                                  /**< Free heap at the beginning of the scope */
+  static uint8_t  _depth;                               /**< Nesting level of the scopes */
+};
+
+#define ED_HEAP_ACCOUNT(account)      EdgeHeapScope _edHeapScope(account)
+#else
+#define ED_HEAP_ACCOUNT(account)      do {} while (0)
+#endif // !ED_HEAP_ACCOUNTING
+
 // Forward references
+class EdgeDriverBase;
 class EdgeUnified;
 
+/**
+ * EdgeRequire: A prerequisite of the EdgeDriver attached to EdgeUnified. It
+ * is either another EdgeDriver that must be running, or a readiness
+ * condition such as WiFi connected. EdgeUnified starts the EdgeDriver once
+ * all its prerequisites hold, and ends it when one of them no longer holds.
+ * @param  driver     EdgeDriver that must be started ahead.
+ * @param  condition  Function that returns true while the condition holds.
+ * EdgeUnified evaluates it only when some state has changed, the sketch
+ * notifies the change of its own condition with EdgeUnified::recheck.
+ */
+class EdgeRequire {
+ public:
+  typedef std::function<bool(void)> EdgeConditionT;
+
+  EdgeRequire(EdgeDriverBase& driver) : driver(&driver) {}
+  EdgeRequire(EdgeConditionT condition) : condition(condition) {}
+  ~EdgeRequire() {}
+
+  bool  holds(void) const;
+  static EdgeRequire  WiFiConnected(void);
+
+  EdgeDriverBase* driver = nullptr;                     /**< EdgeDriver required to be running */
+  EdgeConditionT  condition;                            /**< Readiness condition */
+  bool  wifi = false;                                   /**< The condition depends on the WiFi connection */
+};
+
 /**
  * EdgeDriverBase: Base class of EdgeDriver and provides the basic
  * capabilities of EdgeDriver.
  */
 class EdgeDriverBase {
+  friend class EdgeRequire;
+  friend class EdgeUnified;
+
  public:
   // An identifier that specifies automatic saving and restoration of EdgeData.
   typedef enum PERSISTANCE {
@@ -115,69 +584,223 @@ class EdgeDriverBase {
     ED_PERSISTENT_AUTOSAVE    = 0x10,
   } PERSISTANCE_t;
 
+  // Hardware that takes over the periodic work of the EdgeDriver process.
+  typedef enum OFFLOAD {
+    ED_OFFLOAD_NONE,                                    /**< Polled by EdgeUnified::process */
+    ED_OFFLOAD_PWM,                                     /**< Waveform on a pin by LEDC or analogWrite */
+    ED_OFFLOAD_PULSE,                                   /**< Pulse train on a pin by RMT */
+    ED_OFFLOAD_TIMER,                                   /**< Process callback at the tick of esp_timer or Ticker, run in the loop */
+  } OFFLOAD_t;
+
   // EdgeDriver handler functions; EdgeUnified calls each handler at
   // each stage of the event loop.
   typedef std::function<void(void)>   EdgeDriverHandlerT;
   typedef std::function<void(int)>    EdgeDriverErrorHandlerT;
   typedef std::function<void(ArduinoJson::JsonObject&)> EdgeDataSerializerT;
+  typedef std::function<double(void)> EdgeMetricReaderT;
 
-  EdgeDriverBase() : _enable(true), _interval(0), _tm(0), _persistance(0x00), _jsonBufferSize(0) {}
+  EdgeDriverBase() : _enable(true), _priority(ED_PRIORITY_DEFAULT), _interval(0), _tm(0), _retryDelay(ED_RETRY_DELAY), _retryMaxDelay(ED_RETRY_MAXDELAY), _retryAttempts(ED_RETRY_ATTEMPTS), _retries(0), _retryTm(0), _persistance(0x00), _jsonBufferSize(0) {}
+  // The copy takes over the settings of the EdgeDriver but neither its
+  // running state nor the resources bound at the attach and the start. It
+  // is detached, has no pages, prerequisites, metrics or hardware offload,
+  // and its trace identifier and footprint are given by the next attach.
   EdgeDriverBase(const EdgeDriverBase& rhs) :
-    _enable(rhs._enable),
-    _interval(rhs._interval), _tm(rhs._tm),
+    _enable(rhs._enable), _priority(rhs._priority), _traceId(0),
+    _interval(rhs._interval), _tm(rhs._tm), _slack(rhs._slack),
+    _retryDelay(rhs._retryDelay), _retryMaxDelay(rhs._retryMaxDelay), _retryAttempts(rhs._retryAttempts),
+    _retries(0), _retryTm(0),
     _persistance(rhs._persistance),
     _jsonBufferSize(rhs._jsonBufferSize),
-    _cbStart(rhs._cbStart), _cbProcess(rhs._cbProcess), _cbEnd(rhs._cbEnd), _cbError(rhs._cbError),
+    _budget(rhs._budget), _watchdogDemote(rhs._watchdogDemote), _watchdogLimit(rhs._watchdogLimit),
+    _overrunStreak(0), _demotions(0), _basePriority(0), _baseInterval(0),
+    _superviseDelay(rhs._superviseDelay), _superviseMaxDelay(rhs._superviseMaxDelay),
+    _superviseWindow(rhs._superviseWindow), _superviseFailures(rhs._superviseFailures),
+    _failures(0), _failureTm(0), _lastError(0), _restartPending(false), _restartTm(0), _restartDelay(0),
+    _dependents(rhs._dependents), _requires(),
+    _started(false), _gated(false), _savedDigest(0), _footprint(0), _heap(0), _stats(), _metrics(),
+    _cbStart(rhs._cbStart), _cbProcess(rhs._cbProcess), _cbEnd(rhs._cbEnd), _cbError(rhs._cbError), _cbFlush(rhs._cbFlush),
     _serializer(rhs._serializer), _deserializer(rhs._deserializer),
+    _reporter(rhs._reporter), _telemetry(rhs._telemetry), _telemetryHash(),
+    _offloadType(ED_OFFLOAD_NONE), _offloadPin(0), _offloadHigh(0), _offloadLow(0), _offloadIdle(LOW),
+    _offloadChannel(-1), _offloadHandle(nullptr), _offloadTick(-1), _offloaded(false),
+    _edge(nullptr), _pages(), _pageUris(),
     _edgeDataType(rhs._edgeDataType) {}
 
   // Only an interface for embedding EdgeData types into a class instance.
   virtual const String& getTypeName(void) = 0;
 
   // EdgeDriver process controls
-  void  enable(const bool onOff) { _enable = onOff; }
+  void  enable(const bool onOff);
   void  end(void);
   void  error(const int error);
   void  process(void);
   void  start(const long interval = -1);
+
+  // Hardware offload of the periodic EdgeDriver process
+  bool  isOffloaded(void) const { return _offloaded; }
+  void  offloadClear(void) { _offload(ED_OFFLOAD_NONE, 0, 0, 0); }
+  void  offloadPWM(const uint8_t pin, const uint32_t period, const uint8_t duty = 50);
+  void  offloadPulse(const uint8_t pin, const uint32_t high, const uint32_t low);
+  void  offloadTimer(const uint32_t period) { _offload(ED_OFFLOAD_TIMER, 0, period, 0); }
   
   // Controls the periodicity of the active state of EdgeDriver::process
   void  clearEdgeInterval(void) { setEdgeInterval(0); }
   unsigned long getEdgeInterval(void) const { return _interval; }
   void  setEdgeInterval(const unsigned long interval) { _interval = interval; _tm = millis(); }
+  unsigned long getEdgeSlack(void) const { return _slack; }
+  void  setEdgeSlack(const unsigned long slack);
+
+  // Order of the EdgeDriver::process calls within EdgeUnified::process
+  uint8_t getPriority(void) const { return _priority; }
+  void  setPriority(const uint8_t priority);
+
+  // Retry scheduling with the exponential backoff
+  uint8_t getRetries(void) const { return _retries; }
+  bool  retryLater(void);
+  void  retryPolicy(const unsigned long delay, const unsigned long maxDelay = ED_RETRY_MAXDELAY, const uint8_t attempts = ED_RETRY_ATTEMPTS);
+  void  succeeded(void) { _retries = 0; }
   
   // Serialization and deserialization of EdgeData
   void  autoRestore(const bool onOff);
   void  autoSave(const bool onOff);
   bool  isAutoRestore(void) { return _persistance & ED_PERSISTENT_AUTORESTORE; }
   bool  isAutoSave(void) { return _persistance & ED_PERSISTENT_AUTOSAVE; }
+  bool  isDirty(void) { return !_savedDigest || _digest() != _savedDigest; }
   size_t  restore(AUTOCONNECT_APPLIED_FILECLASS& fs = AUTOCONNECT_APPLIED_FILESYSTEM, const char* fileName = nullptr);
   size_t  save(AUTOCONNECT_APPLIED_FILECLASS& fs = AUTOCONNECT_APPLIED_FILESYSTEM, const char* fileName = nullptr);
   void  serializer(EdgeDataSerializerT serializer, EdgeDataSerializerT deserializer, const size_t bufferSize = ED_SERIALIZE_BUFFER_SIZE);
 
+  // Telemetry of EdgeData pushed by EdgeUnified::events
+  void  telemetry(EdgeDataSerializerT reporter = nullptr);
+
+  // Supervision that restarts the EdgeDriver stopped by an error
+  uint8_t getFailures(void) const { return _failures; }
+  void  restartWith(EdgeDriverBase& dependent) { _dependents.push_back(&dependent); }
+  void  supervise(const unsigned long delay, const unsigned long maxDelay = ED_SUPERVISOR_MAXDELAY, const uint8_t failures = ED_SUPERVISOR_FAILURES, const unsigned long window = ED_SUPERVISOR_WINDOW);
+
+  // Process time budget and the metrics exposed by EdgeUnified::metrics
+  void  counter(PGM_P name, PGM_P help, EdgeMetricReaderT reader) { _metrics.push_back({ name, help, reader, true }); }
+  void  gauge(PGM_P name, PGM_P help, EdgeMetricReaderT reader) { _metrics.push_back({ name, help, reader, false }); }
+  unsigned long getBudget(void) const { return _budget; }
+  void  setBudget(const unsigned long budget) { _budget = budget; }
+  void  watchdog(const uint8_t demote, const uint8_t limit) { _watchdogDemote = demote; _watchdogLimit = limit; }
+
  protected:
+  // A metric registered by the EdgeDriver
+  typedef struct {
+    PGM_P name;                                         /**< Metric name following edge_ */
+    PGM_P help;                                         /**< Description of the metric */
+    EdgeMetricReaderT reader;                           /**< Returns the current value */
+    bool  counter;                                      /**< The value only increases */
+  } EdgeMetric_t;
+
+  // Statistics of the EdgeDriver exposed by EdgeUnified::metrics
+  typedef struct {
+    uint32_t  processes;                                /**< Number of the process calls */
+    uint64_t  processTime;                              /**< Total time [us] of the process calls */
+    uint32_t  processMax;                               /**< Longest process call [us] */
+    uint32_t  overruns;                                 /**< Process calls exceeding the budget */
+    uint32_t  errors;                                   /**< Number of the errors */
+    uint32_t  restarts;                                 /**< Number of the restarts by the supervisor */
+    uint32_t  saves;                                    /**< Number of the saves */
+    uint32_t  saveBytes;                                /**< Total size of the saved EdgeData */
+    uint64_t  saveTime;                                 /**< Total time [us] of the saves */
+    uint32_t  restores;                                 /**< Number of the restorations */
+    uint32_t  restoreBytes;                             /**< Total size of the restored EdgeData */
+    uint64_t  restoreTime;                              /**< Total time [us] of the restorations */
+  } EdgeDriverStats_t;
+
   virtual ~EdgeDriverBase() { end(); }
+  void  _demote(void);
   bool  _elapse(void);
   void  _embedType(const String& pf);
+  void  _offload(const OFFLOAD_t type, const uint8_t pin, const uint32_t high, const uint32_t low);
+  bool  _offloadStart(void);
+  void  _offloadStop(void);
+  bool  _offloadTicked(void);
+  void  _overrun(const uint32_t elapsed);
+  uint32_t  _digest(void);
+  void  _dispose(void);
+  void  _end(const bool flush);
+  bool  _busy(void) const;
+  bool  _ready(void) const;
+  long  _remain(const unsigned long now) const;
+  void  _setEnable(const bool onOff);
   const String& _getType(void) const { return _edgeDataType; }
+  void  _setType(const String& typeName) { _edgeDataType = typeName; }
 
   bool    _enable;                                      /**< The enable status of the EdgeDriver process call */
+  uint8_t _priority;                                    /**< Priority of the EdgeDriver process call */
+  uint16_t  _traceId = 0;                               /**< Identifier in the trace events */
   unsigned long _interval;                              /**< Period during which EdgeDriver::process is enabled */
   unsigned long _tm;                                    /**< Time remaining until next cycle for EdgeDriver::process call */
+  unsigned long _slack = ED_SLACK_DEFAULT;              /**< Tolerance of the period to coalesce the wakeups */
+  unsigned long _retryDelay;                            /**< Initial delay of the retry */
+  unsigned long _retryMaxDelay;                         /**< Maximum delay of the retry */
+  uint8_t _retryAttempts;                               /**< Maximum number of the retry attempts, 0 is unlimited */
+  uint8_t _retries;                                     /**< Number of the retries pending, 0 is not retrying */
+  unsigned long _retryTm;                               /**< Delay until the pending retry */
   uint8_t _persistance;                                 /**< Composite value of PERSISTANCE_t indicating automatic save and restore */
   size_t  _jsonBufferSize;                              /**< Json dynamic buffer allocation size */
+  unsigned long _budget = ED_BUDGET_DEFAULT;            /**< Budget [us] of a process call */
+  uint8_t _watchdogDemote = ED_WATCHDOG_DEMOTE;         /**< Consecutive overruns per demotion */
+  uint8_t _watchdogLimit = ED_WATCHDOG_LIMIT;           /**< Consecutive overruns to stop the EdgeDriver */
+  uint8_t _overrunStreak = 0;                           /**< Number of the consecutive overruns */
+  uint8_t _demotions = 0;                               /**< Number of the demotions since the start */
+  uint8_t _basePriority = 0;                            /**< Priority before the demotion */
+  unsigned long _baseInterval = 0;                      /**< Interval before the demotion */
+  unsigned long _superviseDelay = 0;                    /**< Initial delay of the restart, 0 is unsupervised */
+  unsigned long _superviseMaxDelay = ED_SUPERVISOR_MAXDELAY; /**< Maximum delay of the restart */
+  unsigned long _superviseWindow = ED_SUPERVISOR_WINDOW;   /**< Window counting the failures */
+  uint8_t _superviseFailures = ED_SUPERVISOR_FAILURES;  /**< Failures within the window to escalate */
+  uint8_t _failures = 0;                                /**< Failures within the current window */
+  unsigned long _failureTm = 0;                         /**< Time when the current window began */
+  int _lastError = 0;                                   /**< Error code of the last failure */
+  bool  _restartPending = false;                        /**< The restart is scheduled */
+  unsigned long _restartTm = 0;                         /**< Time when the restart was scheduled */
+  unsigned long _restartDelay = 0;                      /**< Delay of the scheduled restart */
+  std::vector<EdgeDriverBase*>  _dependents;            /**< EdgeDrivers restarted together */
+  std::vector<EdgeRequire>  _requires;                  /**< Prerequisites to start */
+  bool  _started = false;                               /**< Started and not ended yet */
+  bool  _gated = false;                                 /**< Waiting for the prerequisites */
+  uint32_t  _savedDigest = 0;                           /**< Digest of EdgeData saved or restored, 0 is unknown */
+  size_t  _footprint = 0;                               /**< Size of the concrete EdgeDriver class, 0 is unknown */
+  int32_t _heap = 0;                                    /**< Heap attributed to the EdgeDriver */
+  EdgeDriverStats_t _stats = EdgeDriverStats_t();       /**< Statistics for the metrics */
+  std::vector<EdgeMetric_t> _metrics;                   /**< Metrics registered by the EdgeDriver */
 
   EdgeDriverHandlerT  _cbStart   = nullptr;             /**< On-start callback */
   EdgeDriverHandlerT  _cbProcess = nullptr;             /**< On-process callback */
   EdgeDriverHandlerT  _cbEnd     = nullptr;             /**< On-end callback */
   EdgeDriverErrorHandlerT _cbError  = nullptr;          /**< On-error callback */ 
+  EdgeDriverHandlerT  _cbFlush   = nullptr;             /**< On-flush callback before the deep sleep */
 
   EdgeDataSerializerT _serializer   = nullptr;          /**< Serializer */
   EdgeDataSerializerT _deserializer = nullptr;          /**< Deserializer */
+  EdgeDataSerializerT _reporter = nullptr;              /**< Telemetry reporter */
+  bool  _telemetry = false;                             /**< Telemetry is pushed */
+  std::vector<std::pair<uint32_t, uint32_t>>  _telemetryHash; /**< Hashes of key and value of the pushed fields */
+
+  OFFLOAD_t _offloadType = ED_OFFLOAD_NONE;             /**< Declared hardware offload */
+  uint8_t _offloadPin = 0;                              /**< Pin of the offloaded waveform */
+  uint32_t  _offloadHigh = 0;                           /**< High duration [us] of the waveform, or the timer period [us] */
+  uint32_t  _offloadLow = 0;                            /**< Low duration [us] of the waveform */
+  uint8_t _offloadIdle = LOW;                           /**< Pin level to be restored when the offload stops */
+  int8_t  _offloadChannel = -1;                         /**< Allocated LEDC or RMT channel */
+  void* _offloadHandle = nullptr;                       /**< Timer running the offload */
+  int8_t  _offloadTick = -1;                            /**< Slot of the timer tick waiting for the loop */
+  bool  _offloaded = false;                             /**< The hardware runs instead of the process */
+
+  EdgeUnified*  _edge = nullptr;                        /**< EdgeUnified to which the EdgeDriver is attached */
+  std::vector<EdgeAux>  _pages;                         /**< AutoConnectAux pages owned by the EdgeDriver */
+  std::vector<String>   _pageUris;                      /**< Uris of the owned pages currently joined */
 
  private:
   virtual size_t  _dataReader(File& file) = 0;          /**< Default serializer interface */
   virtual size_t  _dataWritter(File& file) = 0;         /**< Default deserializer interface */
+  virtual void  _dataDigest(Print& out) = 0;            /**< Outputs EdgeData to the digest */
+  virtual size_t  _dataSize(void) const = 0;            /**< Size of EdgeData */
+  virtual size_t  _driverSize(void) const = 0;          /**< Size of EdgeDriver<T> */
 
   String  _edgeDataType;                                /**< Declared EdgeData type */
 };
@@ -201,17 +824,18 @@ class EdgeDriver : public EdgeDriverBase {
     EdgeDriverBase::_embedType(String(__PRETTY_FUNCTION__));
     bind(start, process, end);
   }
-  ~EdgeDriver() {}
+  ~EdgeDriver() { _dispose(); }
 
   // Coupling point with EdgeUnified
   void bind(EdgeDriverHandlerT start, EdgeDriverHandlerT process, EdgeDriverHandlerT end) {
-    _cbStart = std::bind(start);
-    _cbProcess = std::bind(process);
-    _cbEnd = std::bind(end);
+    _cbStart = start;
+    _cbProcess = process;
+    _cbEnd = end;
   }
 
   // EdgeDriver process controls
   void onError(EdgeDriverErrorHandlerT error) { _cbError = std::bind(error, std::placeholders::_1); }
+  void onFlush(EdgeDriverHandlerT flush) { _cbFlush = flush; }
 
   // Returns embedded EdgeData type.
   const String& getTypeName(void) override { return _getType(); }
@@ -225,6 +849,9 @@ class EdgeDriver : public EdgeDriverBase {
  private:
   size_t  _dataReader(File& file) override { return file.read(reinterpret_cast<uint8_t*>(&data), sizeof(T)); }
   size_t  _dataWritter(File& file) override { return file.write(reinterpret_cast<const uint8_t*>(&data), sizeof(T)); }
+  void  _dataDigest(Print& out) override { out.write(reinterpret_cast<const uint8_t*>(&data), sizeof(T)); }
+  size_t  _dataSize(void) const override { return sizeof(T); }
+  size_t  _driverSize(void) const override { return sizeof(EdgeDriver<T>); }
 };
 
 /**
@@ -234,6 +861,8 @@ class EdgeDriver : public EdgeDriverBase {
  * and integrates multiple event loops that were separated per device into one.
  */
 class EdgeUnified {
+  friend class EdgeDriverBase;
+
  public:
   EdgeUnified() {}
   ~EdgeUnified() {}
@@ -246,26 +875,198 @@ class EdgeUnified {
   //  class EdgeConfig;
   //  void config(EdgeConfig& config);
 
+  // Job submitted to EdgeUnified. The job returns ED_JOB_CONTINUE to be
+  // called again in the next turn, otherwise the result of the job which
+  // is passed to the completion callback.
+  typedef std::function<int(void)>  EdgeJobT;
+  typedef std::function<void(const uint16_t id, const int result)>  EdgeJobDoneT;
+
+  // Handler of the EdgeDriver that failed too often to be restarted.
+  typedef std::function<void(EdgeDriverBase& driver, const int error)>  EdgeEscalateHandlerT;
+
   // Release candidates functions
   void  abort(const int error);
+  bool  api(void);
+  bool  events(const unsigned long interval = ED_EVENTS_INTERVAL);
   void  attach(EdgeDriverBase& driver, const long interval = -1);
+  void  attach(EdgeDriverBase& driver, const std::vector<EdgeAux>& pages, const long interval = -1);
+  void  attach(EdgeDriverBase& driver, const std::vector<EdgeRequire>& prerequisites, const long interval = -1);
   void  attach(std::vector<std::reference_wrapper<EdgeDriverBase>> drivers);
+  template<typename D>
+  typename std::enable_if<std::is_base_of<EdgeDriverBase, D>::value && !std::is_same<EdgeDriverBase, D>::value>::type attach(D& driver, const long interval = -1) {
+    _recordFootprint<D>(driver);
+    attach(static_cast<EdgeDriverBase&>(driver), interval);
+  }
+  template<typename D>
+  typename std::enable_if<std::is_base_of<EdgeDriverBase, D>::value && !std::is_same<EdgeDriverBase, D>::value>::type attach(D& driver, const std::vector<EdgeAux>& pages, const long interval = -1) {
+    _recordFootprint<D>(driver);
+    attach(static_cast<EdgeDriverBase&>(driver), pages, interval);
+  }
+  template<typename D>
+  typename std::enable_if<std::is_base_of<EdgeDriverBase, D>::value && !std::is_same<EdgeDriverBase, D>::value>::type attach(D& driver, const std::vector<EdgeRequire>& prerequisites, const long interval = -1) {
+    _recordFootprint<D>(driver);
+    attach(static_cast<EdgeDriverBase&>(driver), prerequisites, interval);
+  }
+  bool  boot(void);
+  void  bootMark(PGM_P phase, const EdgeDriverBase* driver = nullptr);
+  size_t  bootReport(Print& out);
   void  detach(const EdgeDriverBase& driver);
+  void  dutyCycle(const unsigned long minSleep = ED_DUTY_MINSLEEP, const unsigned long awakeLimit = ED_DUTY_AWAKELIMIT);
+  size_t  dutyReport(Print& out);
   void  end(void);
   void  join(PGM_P json, AuxHandlerFunctionT auxHandler = nullptr);
   void  join(const __FlashStringHelper* json, AuxHandlerFunctionT auxHandler = nullptr);
   void  join(const std::vector<EdgeAux>& pages);
+  bool  jobs(void);
+  bool  metrics(void);
+  size_t  memoryReport(Print& out);
+  size_t  metricsDump(Print& out);
+  unsigned long nextWake(void);
+  void  onEscalate(EdgeEscalateHandlerT handler) { _onEscalate = handler; }
   void  portal(AutoConnect& portal);
   void  process(AutoConnect& portal);
   void  process(void);
+  void  recheck(void) { _gateChanged = true; }
   bool  release(const String& uri);
   void  restore(AUTOCONNECT_APPLIED_FILECLASS& fs = AUTOCONNECT_APPLIED_FILESYSTEM, const bool autoMount = false);
+  bool  resumed(void);
   void  save(AUTOCONNECT_APPLIED_FILECLASS& fs = AUTOCONNECT_APPLIED_FILESYSTEM, const bool autoMount = false);
   EdgeUnifiedNS::WebServer& server(void) { return _portal->host(); }
+  uint16_t  submit(EdgeJobT job, EdgeJobDoneT done = nullptr);
+  bool  supervisor(void);
+  bool  trace(void);
+  size_t  traceDump(Print& out);
 
  protected:
+  // The fingerprint identifies the JSON description from which the
+  // AutoConnectAux was loaded by its hash and its length.
+  typedef std::pair<uint32_t, size_t> EdgeAuxFingerprintT;
+
+  // An entry of the joined AutoConnectAux index.
+  typedef struct {
+    AutoConnectAux* aux;                                /**< Joined AutoConnectAux instance */
+    EdgeAuxFingerprintT fingerprint;                    /**< Fingerprint of the JSON description source */
+  } EdgeAuxEntry_t;
+
+  // State of the submitted job
+  typedef enum {
+    ED_JOB_PENDING,
+    ED_JOB_RUNNING,
+    ED_JOB_DONE
+  } EdgeJobState_t;
+
+  typedef struct {
+    uint16_t  id;                                       /**< Job identifier */
+    EdgeJobT  job;                                      /**< Job function */
+    EdgeJobDoneT  done;                                 /**< Completion callback */
+    int result;                                         /**< Result of the job */
+    EdgeJobState_t  state;                              /**< State of the job */
+  } EdgeJob_t;
+
+  // Records the size of the concrete EdgeDriver class attached.
+  template<typename D>
+  void  _recordFootprint(D& driver) {
+#ifdef ED_DRIVER_RAM_BUDGET
+    static_assert(sizeof(D) <= ED_DRIVER_RAM_BUDGET, "EdgeDriver exceeds ED_DRIVER_RAM_BUDGET");
+#endif
+    static_cast<EdgeDriverBase&>(driver)._footprint = sizeof(D);
+  }
+
+  // A record of the restart history
+  typedef struct {
+    unsigned long tm;                                   /**< Time of the restart or the escalation [ms] */
+    uint16_t  id;                                       /**< Trace id of the EdgeDriver */
+    int error;                                          /**< Error code of the failure */
+    uint8_t failures;                                   /**< Failures within the window */
+    bool  escalated;                                    /**< Escalated instead of restarting */
+  } EdgeRestart_t;
+
+  void  _apiGet(const String& typeName);
+  void  _apiList(void);
+  void  _apiPut(const String& typeName);
+  void  _acceptEvents(void);
+  void  _bindPages(EdgeDriverBase& driver);
+  EdgeDriverBase* _findDriver(const String& typeName);
+  void  _prioritize(void);
+  void  _pushEvents(void);
+  bool  _detachAux(AutoConnectAux* aux);
+  EdgeAuxFingerprintT _fingerprint(const EdgeAux& page, File& jsonFile);
+  AutoConnectAux* _join(const EdgeAux& page);
+  void  _joinAux(AutoConnectAux* aux);
+  void  _jobsGet(const String& idArg);
+  void  _lockJobs(void);
+  void  _duty(void);
+  void  _endOrdered(void);
+  void  _failed(EdgeDriverBase& driver, const int error);
+  void  _gate(void);
+  void  _hold(EdgeDriverBase& driver);
+  void  _recordRestart(const EdgeDriverBase& driver, const bool escalated);
+  void  _restart(EdgeDriverBase& driver);
+  void  _resume(EdgeDriverBase& driver);
+  void  _runJobs(void);
+  void  _supervise(void);
+  void  _sleep(unsigned long sleep);
+  void  _supervisorGet(void);
+  void  _unlockJobs(void);
+  long  _wake(const unsigned long now);
+  void  _watchWiFi(void);
+#if defined(ARDUINO_ARCH_ESP32)
+  static void _jobWorker(void* edge);
+#endif
+
   std::vector<std::reference_wrapper<EdgeDriverBase>> _drivers;
   std::deque<AutoConnectAux*> _auxQueue;
+  std::map<String, EdgeAuxEntry_t>  _auxIndex;          /**< Joined AutoConnectAux indexed by uri */
+  std::map<EdgeAuxFingerprintT, String> _auxSource;     /**< Uri of joined AutoConnectAux indexed by fingerprint */
+  std::deque<EdgeAuxEntry_t>  _auxParked;               /**< Released AutoConnectAux kept for reuse */
+  EdgeAuxPool _auxPool;                                 /**< AutoConnectAux allocator */
+
+  std::vector<WiFiClient>  _eventClients;              /**< Server-Sent Events connections */
+  unsigned long _eventsInterval = 0;                    /**< Minimum interval of the events */
+  unsigned long _eventsTm = 0;                          /**< Time of the last event */
+  unsigned long _eventsAlive = 0;                       /**< Time of the last transmission */
+  bool  _eventsFull = false;                            /**< Next event sends all fields */
+
+  uint32_t  _loops = 0;                                 /**< Number of the EdgeUnified::process calls */
+  uint32_t  _loopsMark = 0;                             /**< Number of the calls at the last rate update */
+  unsigned long _loopsTm = 0;                           /**< Time of the last rate update */
+  float _loopRate = 0.0f;                               /**< EdgeUnified::process calls per second */
+  bool  _reorder = false;                               /**< EdgeDrivers are sorted after the turn */
+  uint32_t  _joins = 0;                                 /**< Number of the AutoConnectAux joined */
+  uint32_t  _releases = 0;                              /**< Number of the AutoConnectAux released */
+
+  EdgeTrace _trace;                                     /**< Lifecycle events */
+  EdgeBoot  _boot;                                      /**< Boot timeline */
+  uint16_t  _traceIds = 0;                              /**< Last trace id assigned to the EdgeDriver */
+  uint16_t  _traceOwner = 0;                            /**< Trace id of the EdgeDriver binding the pages */
+
+  std::deque<EdgeRestart_t> _restarts;                  /**< Restart history */
+  EdgeEscalateHandlerT  _onEscalate;                    /**< Escalation handler */
+  bool  _restartsPending = false;                       /**< Some EdgeDrivers wait for the restart */
+
+  bool  _dutyCycle = false;                             /**< Duty-cycle mode */
+  unsigned long _dutyMinSleep = ED_DUTY_MINSLEEP;       /**< Shortest sleep of the duty cycle */
+  unsigned long _dutyAwakeLimit = ED_DUTY_AWAKELIMIT;   /**< Limit of the awake time waiting for the pending */
+  unsigned long _dutyTm = 0;                            /**< Time when the duty cycle was set or resumed */
+  uint32_t  _dutyResume = 0;                            /**< Bit n resumes the schedule of trace id n + 1 */
+
+  bool  _coalesce = false;                              /**< Some EdgeDrivers have the slack */
+  bool  _slot = false;                                  /**< The wake slot is open in the current turn */
+
+  volatile bool _gateChanged = false;                   /**< The prerequisites need the evaluation */
+  bool  _wifiWatched = false;                           /**< The WiFi events mark the change */
+#if defined(ARDUINO_ARCH_ESP8266)
+  WiFiEventHandler  _wifiGotIP;                         /**< Handler of the WiFi connection */
+  WiFiEventHandler  _wifiDisconnected;                  /**< Handler of the WiFi disconnection */
+#endif
+
+  std::deque<EdgeJob_t> _jobs;                          /**< Jobs waiting for completion */
+  std::deque<std::pair<uint16_t, int>>  _jobResults;    /**< Results of the completed jobs */
+  uint16_t  _jobId = 0;                                 /**< Identifier of the last submitted job */
+#if defined(ARDUINO_ARCH_ESP32)
+  SemaphoreHandle_t _jobsLock = nullptr;                /**< Guards the jobs shared with the worker */
+  TaskHandle_t  _jobsTask = nullptr;                    /**< Worker task running the jobs */
+#endif
 
   AutoConnect*  _portal = nullptr;
 };